@@ -0,0 +1,208 @@
+#include <charconv>
+#include <climits>
+
+// Aggregates for `show count(*), sum(col), ... [where ...] [group by col]`.
+// Matching rows are processed in batches: group ids and column values are
+// decoded for the whole batch first, then each aggregate runs one tight loop
+// over it. Large inputs are split across threads, each filling its own
+// AggregatePartial, and the partials are merged at the end.
+
+static const size_t PARALLEL_AGGREGATE_MIN = 1u << 15; // rows per thread worth starting one for
+
+enum AggregateFunction : uint8_t { AGG_COUNT, AGG_SUM, AGG_AVG, AGG_MIN, AGG_MAX };
+
+bool parseAggregateFunction(const string &name, AggregateFunction &function) {
+    static const pair<const char *, AggregateFunction> names[] = {
+        {"count", AGG_COUNT}, {"sum", AGG_SUM}, {"avg", AGG_AVG}, {"min", AGG_MIN}, {"max", AGG_MAX}};
+    for (const auto &n : names) {
+        if (name == n.first) {
+            function = n.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+struct AggregateSpec {
+    AggregateFunction function = AGG_COUNT;
+    int column = -1;       // -1 for count(*)
+    string label;          // as shown in the result header, e.g. sum(amount)
+    bool integer = false;  // INT/BIGINT column, summed exactly
+    bool numeric = false;  // any numeric column
+};
+
+// Running state of one aggregate over one group.
+struct Accumulator {
+    uint64_t count = 0;     // rows for count(*), non-null values otherwise
+    int64_t intSum = 0;
+    bool intOverflow = false;
+    double sum = 0;
+    int64_t intMin = INT64_MAX, intMax = INT64_MIN;
+    double min = HUGE_VAL, max = -HUGE_VAL;
+    const string *minText = nullptr, *maxText = nullptr;
+
+    void addInteger(int64_t v) {
+        count++;
+        if ((v > 0 && intSum > INT64_MAX - v) || (v < 0 && intSum < INT64_MIN - v))
+            intOverflow = true;
+        else
+            intSum += v;
+        sum += static_cast<double>(v);
+        intMin = std::min(intMin, v);
+        intMax = std::max(intMax, v);
+    }
+    void addNumber(double v) {
+        count++;
+        sum += v;
+        min = std::min(min, v);
+        max = std::max(max, v);
+    }
+    void addText(const string *v) {
+        count++;
+        if (!minText || *v < *minText)
+            minText = v;
+        if (!maxText || *maxText < *v)
+            maxText = v;
+    }
+    void merge(const Accumulator &o) {
+        if ((o.intSum > 0 && intSum > INT64_MAX - o.intSum) || (o.intSum < 0 && intSum < INT64_MIN - o.intSum))
+            intOverflow = true;
+        else
+            intSum += o.intSum;
+        intOverflow = intOverflow || o.intOverflow;
+        count += o.count;
+        sum += o.sum;
+        intMin = std::min(intMin, o.intMin);
+        intMax = std::max(intMax, o.intMax);
+        min = std::min(min, o.min);
+        max = std::max(max, o.max);
+        if (o.minText && (!minText || *o.minText < *minText))
+            minText = o.minText;
+        if (o.maxText && (!maxText || *maxText < *o.maxText))
+            maxText = o.maxText;
+    }
+};
+
+// Accumulators of every group seen by one worker. Groups of a dictionary
+// encoded column are numbered by dictionary code; other group columns get
+// ids in order of appearance, keyed by value.
+struct AggregatePartial {
+    size_t aggregateCount = 0;
+    vector<Accumulator> accumulators;              // group * aggregateCount + aggregate
+    vector<uint64_t> groupRows;                    // matching rows per group
+    unordered_map<string_view, uint32_t> groupIds; // value keyed groups only
+    vector<string_view> groupValues;
+    uint64_t matched = 0;
+
+    explicit AggregatePartial(size_t aggregates, size_t groups = 1) : aggregateCount(aggregates) {
+        ensureGroups(groups);
+    }
+    void ensureGroups(size_t groups) {
+        if (groupRows.size() >= groups)
+            return;
+        groupRows.resize(groups, 0);
+        accumulators.resize(groups * aggregateCount);
+    }
+    uint32_t groupOf(string_view value) {
+        auto it = groupIds.find(value);
+        if (it != groupIds.end())
+            return it->second;
+        uint32_t id = static_cast<uint32_t>(groupValues.size());
+        groupIds.emplace(value, id);
+        groupValues.push_back(value);
+        ensureGroups(groupValues.size());
+        return id;
+    }
+    Accumulator &at(uint32_t group, size_t aggregate) { return accumulators[group * aggregateCount + aggregate]; }
+
+    // Folds other into this one; byValue when the groups are value keyed.
+    void merge(AggregatePartial &other, bool byValue) {
+        matched += other.matched;
+        for (uint32_t g = 0; g < other.groupRows.size(); g++) {
+            if (other.groupRows[g] == 0)
+                continue;
+            uint32_t target = byValue ? groupOf(other.groupValues[g]) : g;
+            ensureGroups(target + 1);
+            groupRows[target] += other.groupRows[g];
+            for (size_t a = 0; a < aggregateCount; a++)
+                at(target, a).merge(other.at(g, a));
+        }
+    }
+};
+
+// Integer cells of validated INT/BIGINT columns; an explicit '+' is allowed.
+inline bool parseInteger(const string &cell, int64_t &value) {
+    const char *first = cell.data(), *last = cell.data() + cell.size();
+    if (first != last && *first == '+')
+        first++;
+    auto result = from_chars(first, last, value);
+    return result.ec == errc() && result.ptr == last;
+}
+
+// Shortest form that keeps 15 significant digits, without exponent for
+// everyday magnitudes.
+string formatAggregateNumber(double value) {
+    ostringstream out;
+    out << setprecision(15) << value;
+    return out.str();
+}
+
+string renderAggregate(const AggregateSpec &spec, const Accumulator &acc) {
+    if (spec.function == AGG_COUNT)
+        return to_string(acc.count);
+    if (acc.count == 0)
+        return "null";
+    switch (spec.function) {
+    case AGG_SUM:
+        return spec.integer && !acc.intOverflow ? to_string(acc.intSum) : formatAggregateNumber(acc.sum);
+    case AGG_AVG:
+        return formatAggregateNumber(acc.sum / acc.count);
+    case AGG_MIN:
+        if (!spec.numeric)
+            return *acc.minText;
+        return spec.integer ? to_string(acc.intMin) : formatAggregateNumber(acc.min);
+    case AGG_MAX:
+        if (!spec.numeric)
+            return *acc.maxText;
+        return spec.integer ? to_string(acc.intMax) : formatAggregateNumber(acc.max);
+    default:
+        return "";
+    }
+}
+
+// Result sets in the same boxed layout as show, for output that is not a
+// plain table scan.
+void printResultBorder(const vector<size_t> &widths) {
+    for (size_t i = 0; i < widths.size(); i++)
+        cout << (i == 0 ? "+-" : "-+-") << string(widths[i], '-');
+    cout << "-+\n";
+}
+void printResultHeader(const vector<string> &header, const vector<size_t> &widths) {
+    cout << endl;
+    printResultBorder(widths);
+    for (size_t i = 0; i < header.size(); i++) {
+        size_t padding = widths[i] - header[i].length();
+        cout << (i == 0 ? "| " : " | ") << "\033[33m" << string(padding / 2, ' ') << header[i]
+             << string(padding - padding / 2, ' ') << "\033[0m";
+    }
+    cout << " |\n";
+    printResultBorder(widths);
+}
+void printResultRow(const vector<string> &row, const vector<size_t> &widths) {
+    for (size_t i = 0; i < row.size(); i++)
+        cout << (i == 0 ? "| " : " | ") << setw(widths[i]) << left << row[i];
+    cout << " |\n";
+}
+void printResultTable(const vector<string> &header, const vector<vector<string>> &rows) {
+    vector<size_t> widths(header.size());
+    for (size_t i = 0; i < header.size(); i++)
+        widths[i] = header[i].length();
+    for (const auto &row : rows) {
+        for (size_t i = 0; i < row.size(); i++)
+            widths[i] = max(widths[i], row[i].length());
+    }
+    printResultHeader(header, widths);
+    for (const auto &row : rows)
+        printResultRow(row, widths);
+    printResultBorder(widths);
+}
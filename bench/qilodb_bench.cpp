@@ -0,0 +1,371 @@
+// qilodb_bench: times the command pipeline (tokenizer -> Parser -> Table)
+// on a generated table and prints the latency percentiles as JSON.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 bench/qilodb_bench.cpp -lssl -lcrypto -o qilodb_bench
+//
+// Usage:
+//   qilodb_bench [--rows N] [--columns int,varchar,...] [--cardinality K]
+//                [--iterations I] [--codec none|lz4|deflate] [--seed S]
+//                [--label text] [--dir path] [--out file.json] [--keep]
+//
+// The table is created under --dir (a temporary directory by default), which
+// is removed afterwards unless --keep is given.
+
+#include <chrono>
+#include <random>
+
+#include "../parser.cpp"
+
+// Session globals normally defined by main.cpp.
+string fs_path;
+string currentDatabase = "";
+string currentTable = "";
+std::string aesKey = "qilodb-bench-key-0123456789abcde";
+Table* currentTableInstance = nullptr;
+bool exitProgram = false;
+
+struct BenchConfig {
+    size_t rows = 20000;
+    vector<string> columnTypes = {"INT", "VARCHAR", "VARCHAR", "DOUBLE", "DATE", "BOOL"};
+    size_t cardinality = 100;   // distinct values per string column
+    size_t iterations = 20;     // samples for every non-insert workload
+    string codec = "lz4";
+    uint64_t seed = 42;
+    string label;
+    string dir;
+    string outFile;
+    bool keep = false;
+};
+
+// Discards everything written to it.
+class NullBuffer : public streambuf {
+protected:
+    int overflow(int c) override { return c; }
+};
+
+struct Workload {
+    string name;
+    string command;             // representative command, for the report
+    vector<double> samplesUs;   // one latency per execution, in microseconds
+};
+
+// Runs one command line through the same path as the REPL, with its output
+// discarded. Errors are rethrown as runtime_error so the run stops.
+void runCommand(const string &line) {
+    try {
+        list<string> tokens = tokenize(line);
+        if (tokens.empty())
+            return;
+        for (auto &q : splitQueries(tokens)) {
+            Parser parser(q);
+            parser.parse();
+        }
+    } catch (const std::exception &e) {
+        throw runtime_error("\"" + line + "\" failed: " + e.what());
+    } catch (const string &msg) {
+        throw runtime_error("\"" + line + "\" failed: " + msg);
+    } catch (const char *msg) {
+        throw runtime_error("\"" + line + "\" failed: " + string(msg));
+    }
+}
+
+double timeCommand(const string &line) {
+    auto start = chrono::steady_clock::now();
+    runCommand(line);
+    auto stop = chrono::steady_clock::now();
+    return chrono::duration<double, micro>(stop - start).count();
+}
+
+string upperCase(string s) {
+    transform(s.begin(), s.end(), s.begin(), ::toupper);
+    return s;
+}
+
+string lowerCase(string s) {
+    transform(s.begin(), s.end(), s.begin(), ::tolower);
+    return s;
+}
+
+// Generates one cell of the given type. String values are lower case since
+// the tokenizer lower-cases unquoted words.
+string generateValue(const string &type, mt19937_64 &rng, size_t cardinality) {
+    if (type == "INT")
+        return to_string(rng() % 1000000);
+    if (type == "BIGINT")
+        return to_string(rng() % 1000000000000ULL);
+    if (type == "DOUBLE" || type == "BIGDOUBLE") {
+        ostringstream out;
+        out << fixed << setprecision(2) << (rng() % 10000000) / 100.0;
+        return out.str();
+    }
+    if (type == "CHAR")
+        return string(1, static_cast<char>('a' + rng() % 26));
+    if (type == "VARCHAR" || type == "STRING")
+        return "v" + to_string(rng() % cardinality);
+    if (type == "DATE") {
+        char buffer[16];
+        snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d", 2000 + static_cast<int>(rng() % 25),
+                 1 + static_cast<int>(rng() % 12), 1 + static_cast<int>(rng() % 28));
+        return buffer;
+    }
+    if (type == "BOOL")
+        return (rng() & 1) ? "true" : "false";
+    throw runtime_error("unsupported column type " + type);
+}
+
+double percentile(const vector<double> &sorted, double p) {
+    if (sorted.empty())
+        return 0;
+    size_t rank = static_cast<size_t>(ceil(p / 100.0 * sorted.size()));
+    return sorted[rank == 0 ? 0 : rank - 1];
+}
+
+string jsonEscape(const string &s) {
+    string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+string buildReport(const BenchConfig &config, const vector<Workload> &workloads) {
+    ostringstream json;
+    json << fixed << setprecision(2);
+    json << "{\n";
+    json << "  \"label\": \"" << jsonEscape(config.label) << "\",\n";
+    json << "  \"config\": {\"rows\": " << config.rows << ", \"columns\": \"";
+    for (size_t i = 0; i < config.columnTypes.size(); i++)
+        json << (i ? "," : "") << config.columnTypes[i];
+    json << "\", \"cardinality\": " << config.cardinality << ", \"iterations\": " << config.iterations
+         << ", \"codec\": \"" << config.codec << "\", \"seed\": " << config.seed << "},\n";
+    json << "  \"results\": [\n";
+    for (size_t w = 0; w < workloads.size(); w++) {
+        vector<double> sorted = workloads[w].samplesUs;
+        sort(sorted.begin(), sorted.end());
+        double total = 0;
+        for (double s : sorted)
+            total += s;
+        double mean = sorted.empty() ? 0 : total / sorted.size();
+        json << "    {\"name\": \"" << workloads[w].name << "\", \"command\": \"" << jsonEscape(workloads[w].command)
+             << "\", \"samples\": " << sorted.size()
+             << ", \"total_ms\": " << total / 1000.0
+             << ", \"ops_per_sec\": " << (total > 0 ? sorted.size() * 1e6 / total : 0)
+             << ", \"min_us\": " << (sorted.empty() ? 0 : sorted.front())
+             << ", \"mean_us\": " << mean
+             << ", \"p50_us\": " << percentile(sorted, 50)
+             << ", \"p90_us\": " << percentile(sorted, 90)
+             << ", \"p99_us\": " << percentile(sorted, 99)
+             << ", \"max_us\": " << (sorted.empty() ? 0 : sorted.back()) << "}"
+             << (w + 1 < workloads.size() ? "," : "") << "\n";
+    }
+    json << "  ]\n}\n";
+    return json.str();
+}
+
+BenchConfig parseArguments(int argc, char const *argv[]) {
+    BenchConfig config;
+    for (int i = 1; i < argc; i++) {
+        string flag = argv[i];
+        auto next = [&]() -> string {
+            if (i + 1 >= argc)
+                throw invalid_argument("missing value for " + flag);
+            return argv[++i];
+        };
+        if (flag == "--rows")
+            config.rows = stoull(next());
+        else if (flag == "--columns") {
+            config.columnTypes.clear();
+            stringstream ss(next());
+            string type;
+            while (getline(ss, type, ',')) {
+                type = upperCase(trim(type));
+                if (!isValidDataType(type))
+                    throw invalid_argument("unknown column type " + type);
+                config.columnTypes.push_back(type);
+            }
+        }
+        else if (flag == "--cardinality")
+            config.cardinality = max<size_t>(1, stoull(next()));
+        else if (flag == "--iterations")
+            config.iterations = max<size_t>(1, stoull(next()));
+        else if (flag == "--codec")
+            config.codec = lowerCase(next());
+        else if (flag == "--seed")
+            config.seed = stoull(next());
+        else if (flag == "--label")
+            config.label = next();
+        else if (flag == "--dir")
+            config.dir = next();
+        else if (flag == "--out")
+            config.outFile = next();
+        else if (flag == "--keep")
+            config.keep = true;
+        else
+            throw invalid_argument("unknown option " + flag);
+    }
+    if (config.dir.empty())
+        config.dir = (fs::temp_directory_path() / "qilodb_bench").string();
+    return config;
+}
+
+vector<Workload> runBenchmarks(const BenchConfig &config) {
+    mt19937_64 rng(config.seed);
+    vector<Workload> workloads;
+
+    // Column 0 is the primary key; generated columns are c1..cn.
+    string definition = "id INT PRIMARY";
+    int intColumn = -1, stringColumn = -1;
+    for (size_t i = 0; i < config.columnTypes.size(); i++) {
+        definition += ", c" + to_string(i + 1) + " " + config.columnTypes[i];
+        if (config.columnTypes[i] == "INT" && intColumn == -1)
+            intColumn = i + 1;
+        if ((config.columnTypes[i] == "VARCHAR" || config.columnTypes[i] == "STRING") && stringColumn == -1)
+            stringColumn = i + 1;
+    }
+    // Range filters select ~10% of the rows; without a generated INT column
+    // they fall back to the (ordered) primary key.
+    string rangeColumn = intColumn != -1 ? "c" + to_string(intColumn) : "id";
+    string rangeBound = intColumn != -1 ? "100000" : to_string(config.rows / 10);
+
+    runCommand("init bench");
+    runCommand("enter bench");
+    runCommand("make t(" + definition + ") compress " + config.codec);
+
+    // The change workload rewrites a value that some row inside the filter
+    // range actually holds (change fails when nothing matches).
+    int changeColumn = stringColumn != -1 ? stringColumn : intColumn;
+    string changeFrom;
+    string changeFilter = rangeColumn + " < " + rangeBound;
+    Workload insert{"insert", "insert (...)", {}};
+    insert.samplesUs.reserve(config.rows);
+    for (size_t r = 1; r <= config.rows; r++) {
+        string values = to_string(r);
+        vector<string> cells(1, values);
+        for (const string &type : config.columnTypes) {
+            cells.push_back(generateValue(type, rng, config.cardinality));
+            values += ", " + cells.back();
+        }
+        insert.samplesUs.push_back(timeCommand("insert (" + values + ")"));
+        const string &rangeValue = intColumn != -1 ? cells[intColumn] : cells[0];
+        if (changeColumn != -1 && changeFrom.empty() && stoll(rangeValue) < stoll(rangeBound))
+            changeFrom = cells[changeColumn];
+        if (changeColumn != -1 && changeFrom.empty() && r == config.rows) {
+            changeFrom = cells[changeColumn];
+            changeFilter = "id = " + to_string(r);
+        }
+    }
+    workloads.push_back(insert);
+
+    Workload firstCommit{"commit_initial", "commit", {timeCommand("commit")}};
+    workloads.push_back(firstCommit);
+
+    Workload choose{"choose", "choose t", {}};
+    for (size_t i = 0; i < config.iterations; i++) {
+        runCommand("exit");
+        choose.samplesUs.push_back(timeCommand("choose t"));
+    }
+    workloads.push_back(choose);
+
+    vector<pair<string, string>> scans = {{"show_where_range", "show * where " + rangeColumn + " < " + rangeBound}};
+    if (stringColumn != -1)
+        scans.push_back({"show_where_equal", "show * where c" + to_string(stringColumn) + " = 'v1'"});
+    scans.push_back({"show_limit", "show limit ~" + to_string(min<size_t>(100, config.rows))});
+    for (const auto &scan : scans) {
+        Workload workload{scan.first, scan.second, {}};
+        for (size_t i = 0; i < config.iterations; i++)
+            workload.samplesUs.push_back(timeCommand(scan.second));
+        workloads.push_back(workload);
+    }
+
+    // Mutations are undone with rollback, which reloads the committed table.
+    // The primary key cannot be changed, so change needs a generated column.
+    string changeCommand;
+    if (changeColumn != -1) {
+        string changeTo = stringColumn != -1 ? changeFrom + "x" : to_string(stoll(changeFrom) + 1);
+        changeCommand = "change c" + to_string(changeColumn) + " " + changeFrom + " to " + changeTo + " where " + changeFilter;
+    }
+    string deleteCommand = "del where " + rangeColumn + " < " + rangeBound;
+    Workload change{"change_where", changeCommand, {}};
+    Workload del{"del_where", deleteCommand, {}};
+    Workload rollback{"rollback", "rollback", {}};
+    for (size_t i = 0; i < config.iterations; i++) {
+        if (!changeCommand.empty()) {
+            change.samplesUs.push_back(timeCommand(changeCommand));
+            rollback.samplesUs.push_back(timeCommand("rollback"));
+        }
+        del.samplesUs.push_back(timeCommand(deleteCommand));
+        rollback.samplesUs.push_back(timeCommand("rollback"));
+    }
+    if (!changeCommand.empty())
+        workloads.push_back(change);
+    workloads.push_back(del);
+    workloads.push_back(rollback);
+
+    // Every commit rewrites the whole table; one new row per iteration gives
+    // it something to save.
+    Workload commit{"commit", "commit", {}};
+    for (size_t i = 0; i < config.iterations; i++) {
+        string values = to_string(config.rows + 1 + i);
+        for (const string &type : config.columnTypes)
+            values += ", " + generateValue(type, rng, config.cardinality);
+        runCommand("insert (" + values + ")");
+        commit.samplesUs.push_back(timeCommand("commit"));
+    }
+    workloads.push_back(commit);
+
+    runCommand("exit");
+    return workloads;
+}
+
+int main(int argc, char const *argv[]) {
+    BenchConfig config;
+    try {
+        config = parseArguments(argc, argv);
+    } catch (const exception &e) {
+        cerr << "qilodb_bench: " << e.what() << endl;
+        return 1;
+    }
+
+    fs::remove_all(config.dir);
+    fs::create_directories(config.dir);
+    fs_path = config.dir;
+    fs::current_path(fs_path);
+
+    // Command output is not part of the measurement; send it nowhere.
+    NullBuffer nullBuffer;
+    streambuf *coutBuffer = cout.rdbuf(&nullBuffer);
+    streambuf *cerrBuffer = cerr.rdbuf(&nullBuffer);
+    vector<Workload> workloads;
+    string failure;
+    try {
+        workloads = runBenchmarks(config);
+    } catch (const exception &e) {
+        failure = e.what();
+    }
+    cout.rdbuf(coutBuffer);
+    cerr.rdbuf(cerrBuffer);
+
+    fs::current_path(fs::temp_directory_path());
+    if (!config.keep)
+        fs::remove_all(config.dir);
+    if (!failure.empty()) {
+        cerr << "qilodb_bench: " << failure << endl;
+        return 1;
+    }
+
+    string report = buildReport(config, workloads);
+    if (config.outFile.empty()) {
+        cout << report;
+    } else {
+        ofstream out(config.outFile);
+        if (!out) {
+            cerr << "qilodb_bench: could not write " << config.outFile << endl;
+            return 1;
+        }
+        out << report;
+    }
+    return 0;
+}
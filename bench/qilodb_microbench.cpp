@@ -0,0 +1,241 @@
+// qilodb_microbench: Google Benchmark microbenchmarks of the hot primitives
+// (crypto, hashing, tokenizing, value parsing and validation, table header
+// decoding). Besides time, every benchmark reports heap allocations per call
+// and, on x86, TSC cycles per call.
+//
+// Build from the repository root (needs Google Benchmark):
+//   g++ -std=c++17 -O2 bench/qilodb_microbench.cpp -lssl -lcrypto -lbenchmark -lpthread -o qilodb_microbench
+//
+// Usage:
+//   qilodb_microbench [--benchmark_filter=<regex>] [--benchmark_format=json]
+
+#include <benchmark/benchmark.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define QILO_HAVE_TSC 1
+#endif
+
+// Heap allocations are counted by profiler.cpp's operator new.
+#define QILO_COUNT_ALLOCATIONS 1
+#include "../parser.cpp"
+
+// Session globals normally defined by main.cpp.
+string fs_path;
+string currentDatabase = "";
+string currentTable = "";
+std::string aesKey = "qilodb-bench-key-0123456789abcde";
+Table* currentTableInstance = nullptr;
+bool exitProgram = false;
+
+//--------------------------------------------------------------------------------
+// Allocation and cycle counters
+//--------------------------------------------------------------------------------
+// allocationCount comes from profiler.cpp, which replaces the global operator
+// new when QILO_COUNT_ALLOCATIONS is defined (above).
+
+static uint64_t readCycles() {
+#ifdef QILO_HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// Wraps the timed loop: for (auto _ : state) { ... } with start()/finish()
+// around it adds "allocs" and "cycles" counters averaged per iteration.
+class CallCounters {
+private:
+    uint64_t allocations = 0;
+    uint64_t cycles = 0;
+
+public:
+    void start() {
+        allocations = allocationCount.load(memory_order_relaxed);
+        cycles = readCycles();
+    }
+    void finish(benchmark::State &state) {
+        uint64_t cyclesUsed = readCycles() - cycles;
+        uint64_t allocationsUsed = allocationCount.load(memory_order_relaxed) - allocations;
+        state.counters["allocs"] = benchmark::Counter(static_cast<double>(allocationsUsed), benchmark::Counter::kAvgIterations);
+#ifdef QILO_HAVE_TSC
+        state.counters["cycles"] = benchmark::Counter(static_cast<double>(cyclesUsed), benchmark::Counter::kAvgIterations);
+#else
+        (void)cyclesUsed;
+#endif
+    }
+};
+
+//--------------------------------------------------------------------------------
+// Crypto and hashing
+//--------------------------------------------------------------------------------
+static void BM_AesEncrypt(benchmark::State &state) {
+    string plain(state.range(0), 'q');
+    string iv;
+    CallCounters counters;
+    counters.start();
+    for (auto _ : state) {
+        string cipher = aesEncrypt(plain, iv);
+        benchmark::DoNotOptimize(cipher);
+    }
+    counters.finish(state);
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_AesEncrypt)->RangeMultiplier(16)->Range(64, 1 << 20);
+
+static void BM_AesDecrypt(benchmark::State &state) {
+    string plain(state.range(0), 'q');
+    string iv;
+    string cipher = aesEncrypt(plain, iv);
+    CallCounters counters;
+    counters.start();
+    for (auto _ : state) {
+        string decrypted = aesDecrypt(cipher, iv);
+        benchmark::DoNotOptimize(decrypted);
+    }
+    counters.finish(state);
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_AesDecrypt)->RangeMultiplier(16)->Range(64, 1 << 20);
+
+static void BM_Sha256WithSalt(benchmark::State &state) {
+    string password = "correct horse battery staple";
+    CallCounters counters;
+    counters.start();
+    for (auto _ : state) {
+        string hash = sha256WithSalt(password, "qiloDBnits");
+        benchmark::DoNotOptimize(hash);
+    }
+    counters.finish(state);
+}
+BENCHMARK(BM_Sha256WithSalt);
+
+//--------------------------------------------------------------------------------
+// Parsing
+//--------------------------------------------------------------------------------
+static void BM_Tokenize(benchmark::State &state) {
+    static const char *lines[] = {
+        "insert (1024, alice, 'new york', 31.5, 2021-06-30, true)",
+        "show name, age where age >= 30 and country = 'in' or name = \"bob\"",
+    };
+    string line = lines[state.range(0)];
+    CallCounters counters;
+    counters.start();
+    for (auto _ : state) {
+        list<string> tokens = tokenize(line);
+        benchmark::DoNotOptimize(tokens);
+    }
+    counters.finish(state);
+    state.SetLabel(state.range(0) == 0 ? "insert" : "show where");
+}
+BENCHMARK(BM_Tokenize)->DenseRange(0, 1);
+
+static void BM_ExtractValues(benchmark::State &state) {
+    // The values token of an insert as produced by the tokenizer.
+    string command = "1024, alice, 'new york', 31.5, 2021-06-30, true, , 7";
+    CallCounters counters;
+    counters.start();
+    for (auto _ : state) {
+        vector<string> values = extractValues(command);
+        benchmark::DoNotOptimize(values);
+    }
+    counters.finish(state);
+}
+BENCHMARK(BM_ExtractValues);
+
+//--------------------------------------------------------------------------------
+// Validation and comparison
+//--------------------------------------------------------------------------------
+static const pair<DataType, const char *> validationSamples[] = {
+    {TYPE_INT, "123456"},
+    {TYPE_BIGINT, "-9007199254740993"},
+    {TYPE_DOUBLE, "31415.9265"},
+    {TYPE_BIGDOUBLE, "2.718281828459045235"},
+    {TYPE_CHAR, "q"},
+    {TYPE_VARCHAR, "new york"},
+    {TYPE_DATE, "2024-02-29"},
+    {TYPE_BOOL, "False"},
+};
+static const char *dataTypeNames[] = {"INT", "BIGINT", "DOUBLE", "BIGDOUBLE", "CHAR", "VARCHAR", "DATE", "BOOL"};
+
+static void BM_ValidateCell(benchmark::State &state) {
+    const auto &sample = validationSamples[state.range(0)];
+    ValueValidator validator = validatorFor(sample.first);
+    string value = sample.second;
+    CallCounters counters;
+    counters.start();
+    for (auto _ : state) {
+        bool ok = validateCell(validator, value);
+        benchmark::DoNotOptimize(ok);
+    }
+    counters.finish(state);
+    state.SetLabel(dataTypeNames[state.range(0)]);
+}
+BENCHMARK(BM_ValidateCell)->DenseRange(0, 7);
+
+static void BM_CompareValues(benchmark::State &state) {
+    bool numeric = state.range(0) == 0;
+    string actual = numeric ? "4096.5" : "2023-11-05";
+    string expected = numeric ? "1024" : "2022-01-01";
+    CallCounters counters;
+    counters.start();
+    for (auto _ : state) {
+        bool matches = compareValues(actual, ">=", expected, numeric);
+        benchmark::DoNotOptimize(matches);
+    }
+    counters.finish(state);
+    state.SetLabel(numeric ? "numeric" : "string");
+}
+BENCHMARK(BM_CompareValues)->DenseRange(0, 1);
+
+//--------------------------------------------------------------------------------
+// Table header
+//--------------------------------------------------------------------------------
+static const string benchSchemaLine =
+    "id(INT)(PRIMARY),name(VARCHAR)(NOT_NULL),country(VARCHAR)(DEFAULT#in),score(DOUBLE),born(DATE),active(BOOL)";
+
+static void BM_ColumnSchemaParse(benchmark::State &state) {
+    vector<string> constraints = {"NOT_NULL", "UNIQUE", "DEFAULT#in"};
+    CallCounters counters;
+    counters.start();
+    for (auto _ : state) {
+        ColumnSchema column = ColumnSchema::parse("country", "VARCHAR", constraints);
+        benchmark::DoNotOptimize(column);
+    }
+    counters.finish(state);
+}
+BENCHMARK(BM_ColumnSchemaParse);
+
+// Opening a table file decrypts and decodes its header: schema line and the
+// block directory with per-block statistics. range(0) is the block count.
+static void BM_TableHeaderOpen(benchmark::State &state) {
+    string filename = (fs::temp_directory_path() / "qilodb_microbench.bin").string();
+    TableFileWriter writer(CODEC_NONE, benchSchemaLine);
+    for (int64_t b = 0; b < state.range(0); b++) {
+        BlockStats stats;
+        stats.columns.resize(6);
+        for (int i = 0; i < 64; i++) {
+            stats.columns[0].add(to_string(b * ROWS_PER_BLOCK + i), true);
+            stats.columns[1].add("name" + to_string(i), false);
+            stats.columns[2].add(i % 3 ? "in" : "us", false);
+            stats.columns[3].add(to_string(i * 1.5), true);
+            stats.columns[4].add("2020-01-" + to_string(10 + i % 19), false);
+            stats.columns[5].add(i % 2 ? "true" : "false", false);
+        }
+        writer.addBlock(string(256, 'r'), ROWS_PER_BLOCK, stats.encode());
+    }
+    writer.writeTo(filename);
+
+    CallCounters counters;
+    counters.start();
+    for (auto _ : state) {
+        TableFileReader reader;
+        bool opened = reader.open(filename);
+        benchmark::DoNotOptimize(opened);
+        reader.close();
+    }
+    counters.finish(state);
+    fs::remove(filename);
+}
+BENCHMARK(BM_TableHeaderOpen)->Arg(1)->Arg(25)->Arg(250);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,41 @@
+// Per-block Bloom filters over the primary key and the UNIQUE columns.
+// A filter is stored with its block's directory entry (storage.cpp), so it is
+// in memory as soon as the file header or segment directory is read, and a
+// key the filter rules out needs no block to be decrypted.
+//
+// Encoded filter: hash count (1 byte) | bit array. Keys are probed by double
+// hashing a single stableHash() value, as sketches are persisted.
+
+static const size_t BLOOM_BITS_PER_KEY = 10; // ~1% false positives
+static const uint8_t BLOOM_HASHES = 7;
+
+class BloomFilter {
+private:
+    string bits;
+
+public:
+    explicit BloomFilter(size_t keys) : bits((max<size_t>(keys * BLOOM_BITS_PER_KEY, 64) + 7) / 8, '\0') {}
+    void add(const string &key) {
+        uint64_t h = stableHash(key);
+        uint64_t delta = (h >> 33) | (h << 31);
+        uint64_t size = bits.size() * 8;
+        for (uint8_t i = 0; i < BLOOM_HASHES; i++, h += delta)
+            bits[(h % size) / 8] |= static_cast<char>(1 << (h % 8));
+    }
+    string encode() const { return string(1, static_cast<char>(BLOOM_HASHES)) + bits; }
+    // False only when key was never added to the filter encoded in `filter`.
+    // An empty filter (blocks written before filters) may contain anything.
+    static bool mayContain(const string &filter, const string &key) {
+        if (filter.size() < 2)
+            return true;
+        uint8_t hashes = static_cast<uint8_t>(filter[0]);
+        uint64_t h = stableHash(key);
+        uint64_t delta = (h >> 33) | (h << 31);
+        uint64_t size = (filter.size() - 1) * 8;
+        for (uint8_t i = 0; i < hashes; i++, h += delta) {
+            if (!(static_cast<uint8_t>(filter[1 + (h % size) / 8]) & (1 << (h % 8))))
+                return false;
+        }
+        return true;
+    }
+};
@@ -0,0 +1,241 @@
+#include <map>
+
+// Catalogs. Every database folder holds catalog.dat, listing its tables with
+// their schema line (columns, constraints and index definitions), engine,
+// codec, row count and file size, and the root folder holds one listing the
+// databases with their table counts. `list` reads a catalog instead of the
+// folders or the table files, and a table's schema can be looked up without
+// opening it. A catalog is laid out as:
+//   magic (plaintext, 7 bytes) | format version (1 byte) | IV | AES(payload)
+// and replaced atomically (durability.cpp); a commit writes its table file
+// and the catalog in one SyncGroup. An entry whose file size no longer
+// matches its table file, left by a crash between those two writes, is
+// read again from the file header when the catalog is read.
+//
+// A missing catalog, e.g. of a database made before catalogs, is rebuilt
+// from the table file headers when it is first read. Row counts of tables
+// still in the single-envelope layout come from the table_metadata.txt
+// that earlier versions kept, which is removed once the catalog is written.
+
+static const string CATALOG_FILE = "catalog.dat";
+static const string CATALOG_MAGIC = string("QILOCT") + '\x01';
+static const uint8_t CATALOG_VERSION = 1;
+
+struct CatalogTable {
+    string schemaLine;
+    TableEngine engine = ENGINE_REWRITE;
+    CompressionCodec codec = CODEC_LZ4;
+    uint64_t rows = 0;
+    uint64_t bytes = 0; // size of the table file
+
+    bool operator==(const CatalogTable &o) const {
+        return schemaLine == o.schemaLine && engine == o.engine && codec == o.codec && rows == o.rows &&
+               bytes == o.bytes;
+    }
+};
+
+// The payload of a catalog file; false when there is none.
+bool readCatalogPayload(const fs::path &path, string &payload) {
+    ifstream in(path, ios::binary);
+    if (!in.is_open())
+        return false;
+    string bytes{istreambuf_iterator<char>(in), istreambuf_iterator<char>()};
+    if (bytes.size() < TABLE_FILE_PREAMBLE || bytes.compare(0, CATALOG_MAGIC.size(), CATALOG_MAGIC) != 0)
+        throw runtime_error("program_error: catalog " + path.string() + " is corrupted.");
+    if (static_cast<uint8_t>(bytes[CATALOG_MAGIC.size()]) > CATALOG_VERSION)
+        throw runtime_error("program_error: catalog was written by a newer version of qiloDB.");
+    payload = openSection(bytes.substr(TABLE_FILE_PREAMBLE));
+    return true;
+}
+void writeCatalogPayload(const fs::path &path, const string &payload) {
+    string bytes = CATALOG_MAGIC + static_cast<char>(CATALOG_VERSION) + sealSection(payload);
+    writeFileAtomically(path.string(), bytes);
+}
+
+void saveDatabaseCatalog(const fs::path &dbPath, const map<string, CatalogTable> &tables) {
+    ByteWriter out;
+    out.putU32(static_cast<uint32_t>(tables.size()));
+    for (const auto &entry : tables) {
+        out.putString(entry.first);
+        out.putString(entry.second.schemaLine);
+        out.putU8(entry.second.engine);
+        out.putU8(entry.second.codec);
+        out.putU64(entry.second.rows);
+        out.putU64(entry.second.bytes);
+    }
+    writeCatalogPayload(dbPath / CATALOG_FILE, out.buffer);
+}
+
+// Row counts from the text metadata file of earlier versions.
+map<string, uint64_t> readLegacyRowCounts(const fs::path &dbPath) {
+    map<string, uint64_t> counts;
+    ifstream in(dbPath / "table_metadata.txt");
+    string line;
+    while (getline(in, line)) {
+        istringstream iss(line);
+        string name, dash, rowsWord;
+        uint64_t rows;
+        if (iss >> name >> dash >> rows >> rowsWord && dash == "-" && rowsWord == "rows")
+            counts[name] = rows;
+    }
+    return counts;
+}
+
+// The entry of a table read from its file header.
+CatalogTable catalogEntryFromFile(const fs::path &path, const map<string, uint64_t> &legacyRows) {
+    CatalogTable table;
+    table.bytes = fs::file_size(path);
+    TableFileReader reader;
+    if (reader.open(path.string())) {
+        table.schemaLine = reader.header().schemaLine;
+        table.engine = reader.header().engine;
+        table.codec = reader.header().codec;
+        for (const auto &block : reader.header().blocks)
+            table.rows += block.rowCount;
+        for (const auto &segment : reader.header().segments)
+            table.rows -= segment.deletedKeys.size();
+    } else {
+        auto it = legacyRows.find(path.stem().string());
+        if (it != legacyRows.end())
+            table.rows = it->second;
+    }
+    return table;
+}
+
+// Reads the header of every table file of a database.
+map<string, CatalogTable> rebuildDatabaseCatalog(const fs::path &dbPath) {
+    map<string, uint64_t> legacyRows = readLegacyRowCounts(dbPath);
+    map<string, CatalogTable> tables;
+    for (const auto &entry : fs::directory_iterator(dbPath)) {
+        if (!entry.is_regular_file() || entry.path().extension() != ".bin")
+            continue;
+        string name = entry.path().stem().string();
+        if (name.empty() || name[0] == '.')
+            continue;
+        tables[name] = catalogEntryFromFile(entry.path(), legacyRows);
+    }
+    saveDatabaseCatalog(dbPath, tables);
+    std::error_code ec;
+    fs::remove(dbPath / "table_metadata.txt", ec);
+    return tables;
+}
+
+// The tables of a database by name.
+map<string, CatalogTable> databaseCatalog(const fs::path &dbPath) {
+    string payload;
+    if (!readCatalogPayload(dbPath / CATALOG_FILE, payload))
+        return rebuildDatabaseCatalog(dbPath);
+    map<string, CatalogTable> tables;
+    ByteReader in(payload);
+    uint32_t count = in.getU32();
+    for (uint32_t i = 0; i < count; i++) {
+        string name = in.getString();
+        CatalogTable &table = tables[name];
+        table.schemaLine = in.getString();
+        table.engine = static_cast<TableEngine>(in.getU8());
+        table.codec = static_cast<CompressionCodec>(in.getU8());
+        table.rows = in.getU64();
+        table.bytes = in.getU64();
+    }
+    // Stale entries are repaired; the catalog is only written when one was.
+    bool repaired = false;
+    for (auto it = tables.begin(); it != tables.end();) {
+        fs::path file = dbPath / (it->first + ".bin");
+        std::error_code ec;
+        uint64_t bytes = fs::file_size(file, ec);
+        if (ec) {
+            it = tables.erase(it);
+            repaired = true;
+            continue;
+        }
+        if (bytes != it->second.bytes) {
+            it->second = catalogEntryFromFile(file, {});
+            repaired = true;
+        }
+        ++it;
+    }
+    if (repaired)
+        saveDatabaseCatalog(dbPath, tables);
+    return tables;
+}
+
+void saveRootCatalog(const map<string, uint32_t> &databases) {
+    ByteWriter out;
+    out.putU32(static_cast<uint32_t>(databases.size()));
+    for (const auto &entry : databases) {
+        out.putString(entry.first);
+        out.putU32(entry.second);
+    }
+    writeCatalogPayload(fs::path(fs_path) / CATALOG_FILE, out.buffer);
+}
+
+// Table counts of the databases by name.
+map<string, uint32_t> rootCatalog() {
+    map<string, uint32_t> databases;
+    string payload;
+    if (readCatalogPayload(fs::path(fs_path) / CATALOG_FILE, payload)) {
+        ByteReader in(payload);
+        uint32_t count = in.getU32();
+        for (uint32_t i = 0; i < count; i++) {
+            string name = in.getString();
+            databases[name] = in.getU32();
+        }
+        return databases;
+    }
+    for (const auto &entry : fs::directory_iterator(fs::path(fs_path))) {
+        string name = entry.path().filename().string();
+        if (entry.is_directory() && !name.empty() && name[0] != '.')
+            databases[name] = static_cast<uint32_t>(databaseCatalog(entry.path()).size());
+    }
+    saveRootCatalog(databases);
+    return databases;
+}
+
+void catalogSetTableCount(const string &database, uint32_t tables) {
+    map<string, uint32_t> databases = rootCatalog();
+    auto it = databases.find(database);
+    if (it != databases.end() && it->second == tables)
+        return;
+    databases[database] = tables;
+    saveRootCatalog(databases);
+}
+void catalogRemoveDatabase(const string &database) {
+    map<string, uint32_t> databases = rootCatalog();
+    if (databases.erase(database))
+        saveRootCatalog(databases);
+}
+// Adds or updates a table of the current database.
+void catalogPutTable(const string &name, const CatalogTable &table) {
+    fs::path dbPath = fs::path(fs_path) / currentDatabase;
+    map<string, CatalogTable> tables = databaseCatalog(dbPath);
+    auto it = tables.find(name);
+    if (it != tables.end() && it->second == table)
+        return;
+    tables[name] = table;
+    saveDatabaseCatalog(dbPath, tables);
+    catalogSetTableCount(currentDatabase, static_cast<uint32_t>(tables.size()));
+}
+void catalogRemoveTable(const string &name) {
+    fs::path dbPath = fs::path(fs_path) / currentDatabase;
+    map<string, CatalogTable> tables = databaseCatalog(dbPath);
+    if (tables.erase(name))
+        saveDatabaseCatalog(dbPath, tables);
+    catalogSetTableCount(currentDatabase, static_cast<uint32_t>(tables.size()));
+}
+
+// Seals a catalog under a new key, see rotateTableFileKey().
+void rotateCatalogKey(const fs::path &path, const string &oldKey, const string &newKey) {
+    string savedKey = aesKey;
+    try {
+        aesKey = oldKey;
+        string payload;
+        if (readCatalogPayload(path, payload)) {
+            aesKey = newKey;
+            writeCatalogPayload(path, payload);
+        }
+    } catch (...) {
+        aesKey = savedKey;
+        throw;
+    }
+    aesKey = savedKey;
+}
@@ -0,0 +1,38 @@
+#include <deque>
+#include <string_view>
+
+// Dictionary for a low-cardinality string column.
+// Every distinct value is stored once and rows only keep its 32-bit code.
+// Codes are stable for the lifetime of the dictionary (entries are never
+// removed), so a code looked up once can be compared against many rows.
+class StringDictionary {
+private:
+    // deque keeps element addresses stable, so the index can key on views.
+    deque<string> entries;
+    unordered_map<string_view, uint32_t> index;
+
+public:
+    static constexpr uint32_t NOT_FOUND = 0xFFFFFFFFu;
+
+    // Returns the code of value, adding it to the dictionary if needed.
+    uint32_t intern(const string &value) {
+        auto it = index.find(value);
+        if (it != index.end())
+            return it->second;
+        uint32_t code = static_cast<uint32_t>(entries.size());
+        entries.push_back(value);
+        index.emplace(string_view(entries.back()), code);
+        return code;
+    }
+    // Returns the code of value or NOT_FOUND, never modifies the dictionary.
+    uint32_t find(const string &value) const {
+        auto it = index.find(value);
+        return it == index.end() ? NOT_FOUND : it->second;
+    }
+    const string &valueOf(uint32_t code) const { return entries[code]; }
+    size_t size() const { return entries.size(); }
+    void clear() {
+        index.clear();
+        entries.clear();
+    }
+};
@@ -0,0 +1,169 @@
+#include <fcntl.h>
+#include <set>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// Crash-safe writes. A file that is rewritten as a whole (a table file, a
+// catalog) is written to "<name>.tmp" and renamed over the
+// original, so a crash leaves either the old or the new version, never a
+// truncated one. Appended segments are flushed after they are written; a
+// torn one is ignored on open (storage.cpp).
+//
+// \sync sets how much is flushed to the device on each write:
+//   full   - the file before it is renamed and the directory after, so a
+//            commit survives a power loss once it has returned (default)
+//   normal - the file only; after a power loss the rename may be lost and
+//            the table read as of the previous commit
+//   off    - nothing; a crash of the process is still safe, a power loss
+//            may lose recent commits
+
+enum SyncMode : uint8_t { SYNC_OFF = 0, SYNC_NORMAL = 1, SYNC_FULL = 2 };
+SyncMode syncMode = SYNC_FULL;
+
+string syncModeName(SyncMode mode) {
+    switch (mode) {
+        case SYNC_OFF: return "off";
+        case SYNC_NORMAL: return "normal";
+        case SYNC_FULL: return "full";
+    }
+    return "unknown";
+}
+SyncMode parseSyncMode(const string &name) {
+    string lower = name;
+    transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    if (lower == "off")
+        return SYNC_OFF;
+    if (lower == "normal")
+        return SYNC_NORMAL;
+    if (lower == "full")
+        return SYNC_FULL;
+    throw ("syntax_error: \\sync -> expected full, normal or off, got \"" + name + "\".");
+}
+
+// Flushes a file, or a directory's entries, to the device.
+void syncPath(const string &path, [[maybe_unused]] bool directory) {
+#ifdef _WIN32
+    // A directory cannot be opened to flush its entries here.
+    if (directory)
+        return;
+    int fd = _open(path.c_str(), _O_RDWR | _O_BINARY);
+    bool synced = fd >= 0;
+    if (synced) {
+        synced = _commit(fd) == 0;
+        _close(fd);
+    }
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    bool synced = fd >= 0;
+    if (synced) {
+#ifdef F_FULLFSYNC
+        // fsync on macOS leaves the data in the drive's cache.
+        synced = (!directory && fcntl(fd, F_FULLFSYNC) == 0) || fsync(fd) == 0;
+#else
+        synced = fsync(fd) == 0;
+#endif
+        close(fd);
+    }
+#endif
+    if (!synced)
+        throw runtime_error("program_error: could not flush " + path + " to disk.");
+    fileSyncsMetric.add();
+}
+
+// Group commit. While a SyncGroup is open, the flushes that do not have to
+// precede a rename (files written in place, directories after a rename) are
+// collected instead of issued, and flush() issues each of them once: the
+// files first, then the directories. A commit opens one around the table
+// file and the catalog, so both share one directory flush, and is
+// reported only after flush() returns; rotating the key flushes each
+// database directory once for all of its tables. Groups do not nest: an
+// inner group leaves its flushes to the outermost one.
+class SyncGroup {
+private:
+    static SyncGroup *&open() {
+        static SyncGroup *group = nullptr;
+        return group;
+    }
+    set<string> files;
+    set<string> directories;
+    bool outermost;
+
+public:
+    SyncGroup() : outermost(open() == nullptr) {
+        if (outermost)
+            open() = this;
+    }
+    ~SyncGroup() {
+        if (outermost)
+            open() = nullptr;
+    }
+    SyncGroup(const SyncGroup &) = delete;
+    SyncGroup &operator=(const SyncGroup &) = delete;
+
+    // Defers a flush to the open group; false when there is none.
+    static bool defer(const string &path, bool directory) {
+        SyncGroup *group = open();
+        if (!group)
+            return false;
+        (directory ? group->directories : group->files).insert(path);
+        return true;
+    }
+    // Drops a deferred flush of a file that has been flushed since.
+    static void flushed(const string &path) {
+        if (open())
+            open()->files.erase(path);
+    }
+    void flush() {
+        if (!outermost)
+            return;
+        for (const string &path : files)
+            syncPath(path, false);
+        for (const string &path : directories)
+            syncPath(path, true);
+        files.clear();
+        directories.clear();
+    }
+};
+
+// Flushes a file written in place (an appended segment).
+void syncWrittenFile(const string &path) {
+    if (syncMode != SYNC_OFF && !SyncGroup::defer(path, false))
+        syncPath(path, false);
+}
+
+// Renames a completely written temp file over path.
+void replaceFile(const string &temp, const string &path) {
+    if (syncMode != SYNC_OFF) {
+        syncPath(temp, false);
+        SyncGroup::flushed(temp);
+    }
+    std::error_code ec;
+    fs::rename(temp, path, ec);
+    if (ec) {
+        fs::remove(temp, ec);
+        throw runtime_error("program_error: could not replace " + path + ".");
+    }
+    if (syncMode == SYNC_FULL) {
+        string dir = fs::absolute(fs::path(path)).parent_path().string();
+        if (!SyncGroup::defer(dir, true))
+            syncPath(dir, true);
+    }
+}
+
+// Replaces path with contents, see replaceFile().
+void writeFileAtomically(const string &path, const string &contents) {
+    string temp = path + ".tmp";
+    {
+        ofstream out(temp, ios::binary | ios::trunc);
+        if (!out.is_open())
+            throw runtime_error("program_error: could not write " + path + ".");
+        out.write(contents.data(), contents.size());
+        out.close();
+        if (!out)
+            throw runtime_error("program_error: could not write " + path + ".");
+    }
+    replaceFile(temp, path);
+}
@@ -0,0 +1,169 @@
+// Full-text index for `make fulltext index on <col>` and the
+// `<col> matches 'words'` condition. Values are split into words (runs of
+// letters, digits and non-ASCII bytes, ASCII case folded) and every word maps
+// to the dictionary codes of the values containing it. A condition matches
+// the values holding all of its words, and the table's lists of rows per
+// code (Table::fulltextRows) turn those into the rows a scan visits. Both
+// are built by the first MATCHES that needs them, not when a table opens.
+
+static const uint32_t POSTING_BLOCK = 128; // codes per skip table entry
+
+// Appends the distinct words of text to terms, in order of appearance.
+void fulltextTerms(const string &text, vector<string> &terms) {
+    string word;
+    auto flush = [&]() {
+        if (!word.empty() && find(terms.begin(), terms.end(), word) == terms.end())
+            terms.push_back(word);
+        word.clear();
+    };
+    for (char c : text) {
+        unsigned char u = static_cast<unsigned char>(c);
+        if (isalnum(u) || u >= 0x80)
+            word.push_back(static_cast<char>(u < 0x80 ? tolower(u) : u));
+        else
+            flush();
+    }
+    flush();
+}
+
+// Ascending dictionary codes, each stored as a varint of its distance from
+// the previous one. Every POSTING_BLOCK-th code starts a block and is stored
+// whole; the skip table holds each block's first code and byte offset so a
+// cursor can jump over blocks it does not need to decode.
+class PostingList {
+private:
+    string bytes;
+    vector<uint32_t> blockFirst;
+    vector<uint32_t> blockOffset;
+    uint32_t count = 0;
+    uint32_t last = 0;
+
+    void putVarint(uint32_t v) {
+        while (v >= 0x80) {
+            bytes.push_back(static_cast<char>(v | 0x80));
+            v >>= 7;
+        }
+        bytes.push_back(static_cast<char>(v));
+    }
+
+public:
+    void append(uint32_t code) {
+        if (count % POSTING_BLOCK == 0) {
+            blockFirst.push_back(code);
+            blockOffset.push_back(static_cast<uint32_t>(bytes.size()));
+            putVarint(code);
+        } else {
+            putVarint(code - last);
+        }
+        last = code;
+        count++;
+    }
+    uint32_t size() const { return count; }
+
+    class Cursor {
+    private:
+        const PostingList *list;
+        size_t offset = 0;     // next byte to decode
+        uint32_t consumed = 0; // codes decoded so far
+
+        uint32_t getVarint() {
+            uint32_t v = 0;
+            for (int shift = 0;; shift += 7) {
+                uint8_t b = static_cast<uint8_t>(list->bytes[offset++]);
+                v |= static_cast<uint32_t>(b & 0x7F) << shift;
+                if (b < 0x80)
+                    return v;
+            }
+        }
+
+    public:
+        uint32_t value = 0;
+        bool valid = false;
+
+        explicit Cursor(const PostingList &postings) : list(&postings) { next(); }
+        void next() {
+            valid = consumed < list->count;
+            if (!valid)
+                return;
+            uint32_t v = getVarint();
+            value = consumed % POSTING_BLOCK == 0 ? v : value + v;
+            consumed++;
+        }
+        // Moves to the first code >= target.
+        void seek(uint32_t target) {
+            if (!valid || value >= target)
+                return;
+            // Last block starting at or before target; jump there if it is ahead.
+            size_t block = upper_bound(list->blockFirst.begin(), list->blockFirst.end(), target) -
+                           list->blockFirst.begin() - 1;
+            if (block * POSTING_BLOCK >= consumed) {
+                offset = list->blockOffset[block];
+                consumed = static_cast<uint32_t>(block * POSTING_BLOCK);
+                next();
+            }
+            while (valid && value < target)
+                next();
+        }
+    };
+};
+
+// Postings of one dictionary encoded column. Dictionary codes are never
+// removed, so the index is extended as the dictionary grows; deleted rows
+// need no maintenance because matches are looked up by the rows' codes.
+class FulltextIndex {
+private:
+    unordered_map<string, PostingList> postings;
+    size_t indexed = 0; // codes [0, indexed) are in postings
+
+public:
+    void update(const StringDictionary &dict) {
+        vector<string> terms;
+        for (; indexed < dict.size(); indexed++) {
+            const string &value = dict.valueOf(static_cast<uint32_t>(indexed));
+            if (value == "null")
+                continue;
+            terms.clear();
+            fulltextTerms(value, terms);
+            for (const string &term : terms)
+                postings[term].append(static_cast<uint32_t>(indexed));
+        }
+    }
+    // Codes of the values containing every term, ascending. The lists are
+    // intersected by leapfrogging: each cursor seeks to the largest code seen
+    // so far until all of them agree.
+    vector<uint32_t> matching(const vector<string> &terms) const {
+        vector<PostingList::Cursor> cursors;
+        vector<const PostingList *> lists;
+        for (const string &term : terms) {
+            auto it = postings.find(term);
+            if (it == postings.end())
+                return {};
+            lists.push_back(&it->second);
+        }
+        sort(lists.begin(), lists.end(), [](const PostingList *a, const PostingList *b) { return a->size() < b->size(); });
+        for (const PostingList *list : lists)
+            cursors.emplace_back(*list);
+        vector<uint32_t> result;
+        if (cursors.empty())
+            return result;
+        while (cursors[0].valid) {
+            uint32_t target = cursors[0].value;
+            bool agreed = true;
+            for (size_t c = 1; c < cursors.size(); c++) {
+                cursors[c].seek(target);
+                if (!cursors[c].valid)
+                    return result;
+                if (cursors[c].value != target) {
+                    cursors[0].seek(cursors[c].value);
+                    agreed = false;
+                    break;
+                }
+            }
+            if (agreed) {
+                result.push_back(target);
+                cursors[0].next();
+            }
+        }
+        return result;
+    }
+};
@@ -0,0 +1,60 @@
+// Joins for `show <cols> from <a> join <b> on a.col = b.col [where ...]`.
+// The side with fewer rows left after the WHERE conditions is put in a hash
+// table keyed by the join value, and the other side is probed against it in
+// batches, each batch split across threads and printed in probe order before
+// the next one starts. When a join column is the primary key of its table,
+// rows are looked up by key in that table instead and no hash table is built.
+
+static const size_t JOIN_PROBE_BATCH = 1u << 16;    // probe rows matched before printing
+static const size_t PARALLEL_JOIN_MIN = 1u << 13;   // probe rows per thread worth starting one for
+static const size_t JOIN_MAX_OR_GROUPS = 64;        // one bit per OR group in a row's match mask
+
+enum JoinSide : uint8_t { JOIN_LEFT = 0, JOIN_RIGHT = 1 };
+
+// A column of either table, written as table.col or as a plain col when
+// only one of the tables has it.
+struct JoinColumn {
+    JoinSide side = JOIN_LEFT;
+    int column = -1;
+    string label; // as shown in the result header
+};
+
+// Rows of one side that passed its WHERE conditions. Bit g of a row's mask
+// is set when the row satisfies this side's part of OR group g.
+struct JoinInput {
+    vector<const Row *> rows;
+    vector<uint64_t> masks;
+};
+
+// Build side of a hash join. Rows with the same key are chained through
+// next in scan order; values are views into the rows' cells.
+class JoinHashTable {
+private:
+    static constexpr uint32_t END = UINT32_MAX;
+    unordered_map<string_view, uint32_t> heads; // first entry of each key
+    vector<uint32_t> next;
+
+public:
+    explicit JoinHashTable(const vector<string_view> &keys) : next(keys.size(), END) {
+        heads.reserve(keys.size());
+        // Inserted back to front so that every chain starts with its first row.
+        for (size_t i = keys.size(); i-- > 0;) {
+            if (keys[i] == "null")
+                continue; // nulls never join
+            auto result = heads.emplace(keys[i], static_cast<uint32_t>(i));
+            if (!result.second) {
+                next[i] = result.first->second;
+                result.first->second = static_cast<uint32_t>(i);
+            }
+        }
+    }
+    // Calls visit(entry) for every build row whose key equals value.
+    template <typename Visit>
+    void forEachMatch(string_view value, Visit visit) const {
+        auto it = heads.find(value);
+        if (it == heads.end())
+            return;
+        for (uint32_t entry = it->second; entry != END; entry = next[entry])
+            visit(entry);
+    }
+};
@@ -20,7 +20,26 @@
 #define CLOSE "close"
 #define HEAD "head"
 #define LIMIT "limit"
+#define ORDER "order"
+#define BY "by"
+#define ASC "asc"
+#define DESC "desc"
+#define GROUP "group"
+#define FROM "from"
+#define JOIN "join"
+#define ON "on"
+#define FULLTEXT "fulltext" // make fulltext index on <col>
+#define INDEX "index"
+#define MATCHES "matches" // <col> matches 'words'
 #define TILDE '~'
 #define TO "to"
 #define DESCRIBE "describe"
-#define HELP "help"
\ No newline at end of file
+#define HELP "help"
+#define COMPRESS "compress" // block compression codec of a table
+#define STORAGE_ENGINE "engine" // write path of a table, see TableEngine (ENGINE is taken by OpenSSL)
+#define TIMING "\\timing" // toggles per-command timing
+#define PROFILE "profile" // runs a statement with phase timing
+#define STATS "stats" // prints the monitoring metrics
+#define SLOWLOG "\\slowlog" // sets the slow query log threshold
+#define PAGER "\\pager" // pauses show output every N rows
+#define SYNC "\\sync" // how much a commit flushes to disk, see durability.cpp
@@ -15,7 +15,6 @@
 #include <cstdio>
 #include <map>
 #include <unordered_set>
-#include <regex>
 #include <iomanip>
 #include "keywords.cpp"
 using namespace std;
@@ -0,0 +1,183 @@
+#include <cstring>
+
+// Patterns of `show ... like <pattern>`. % matches any run of characters, _
+// any single character, and * is the same as %. A pattern without wildcards
+// matches the values that start with it, as LIKE always has. Matching
+// ignores ASCII case.
+//
+// A pattern is compiled once into the literal segments between its %s.
+// Segments without _ are found with memmem; the first and last segment are
+// pinned to the ends of the value unless the pattern starts or ends with %.
+
+#ifndef QILO_TRIGRAM_MIN_ENTRIES
+#define QILO_TRIGRAM_MIN_ENTRIES 4096 // distinct values before a column gets a trigram index
+#endif
+
+inline char foldCase(char c) { return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c; }
+
+// Three folded bytes packed into one key.
+inline uint32_t trigramKey(const char *p) {
+    return (uint32_t(uint8_t(p[0])) << 16) | (uint32_t(uint8_t(p[1])) << 8) | uint32_t(uint8_t(p[2]));
+}
+
+class LikePattern {
+private:
+    struct Segment {
+        string text;       // folded
+        bool anyChar;      // contains _
+    };
+    vector<Segment> segments; // non-empty pieces between %s, in order
+    bool anchoredStart = true;
+    bool anchoredEnd = true;
+    mutable string folded;    // value being matched, reused between calls
+
+    bool matchesAt(const Segment &segment, size_t pos) const {
+        const string &text = segment.text;
+        if (!segment.anyChar)
+            return folded.compare(pos, text.size(), text) == 0;
+        for (size_t i = 0; i < text.size(); i++) {
+            if (text[i] != '_' && text[i] != folded[pos + i])
+                return false;
+        }
+        return true;
+    }
+    // First position in [from, limit - length] where segment matches, or npos.
+    size_t search(const Segment &segment, size_t from, size_t limit) const {
+        size_t length = segment.text.size();
+        if (limit < from + length)
+            return string::npos;
+        if (!segment.anyChar) {
+#ifdef _WIN32
+            size_t found = string_view(folded.data() + from, limit - from).find(segment.text);
+            return found == string_view::npos ? string::npos : from + found;
+#else
+            const void *found = memmem(folded.data() + from, limit - from, segment.text.data(), length);
+            return found ? static_cast<const char *>(found) - folded.data() : string::npos;
+#endif
+        }
+        for (size_t pos = from; pos + length <= limit; pos++) {
+            if (matchesAt(segment, pos))
+                return pos;
+        }
+        return string::npos;
+    }
+
+public:
+    explicit LikePattern(const string &pattern) {
+        string text;
+        for (char c : pattern)
+            text.push_back(c == '*' ? '%' : foldCase(c));
+        if (text.find_first_of("%_") == string::npos)
+            text.push_back('%');
+        anchoredStart = text.front() != '%';
+        anchoredEnd = text.back() != '%';
+        size_t start = 0;
+        while (start <= text.size()) {
+            size_t end = text.find('%', start);
+            if (end == string::npos)
+                end = text.size();
+            if (end > start) {
+                string piece = text.substr(start, end - start);
+                bool anyChar = piece.find('_') != string::npos;
+                segments.push_back({std::move(piece), anyChar});
+            }
+            start = end + 1;
+        }
+    }
+
+    bool matches(const string &value) const {
+        folded.resize(value.size());
+        for (size_t i = 0; i < value.size(); i++)
+            folded[i] = foldCase(value[i]);
+        size_t pos = 0, limit = folded.size();
+        size_t first = 0, last = segments.size();
+        if (segments.empty())
+            return !anchoredStart || folded.empty();
+        if (segments.size() == 1 && anchoredStart && anchoredEnd)
+            return folded.size() == segments[0].text.size() && matchesAt(segments[0], 0);
+        if (anchoredStart) {
+            if (folded.size() < segments[0].text.size() || !matchesAt(segments[0], 0))
+                return false;
+            pos = segments[0].text.size();
+            first = 1;
+        }
+        if (anchoredEnd) {
+            const Segment &tail = segments.back();
+            if (limit < pos + tail.text.size() || !matchesAt(tail, limit - tail.text.size()))
+                return false;
+            limit -= tail.text.size();
+            last--;
+        }
+        for (size_t s = first; s < last; s++) {
+            size_t found = search(segments[s], pos, limit);
+            if (found == string::npos)
+                return false;
+            pos = found + segments[s].text.size();
+        }
+        return true;
+    }
+    // Trigrams every matching value contains: those of the literal runs of
+    // three or more characters.
+    vector<uint32_t> requiredTrigrams() const {
+        vector<uint32_t> trigrams;
+        for (const auto &segment : segments) {
+            const string &text = segment.text;
+            size_t run = 0;
+            for (size_t i = 0; i < text.size(); i++) {
+                run = text[i] == '_' ? 0 : run + 1;
+                if (run >= 3)
+                    trigrams.push_back(trigramKey(text.data() + i - 2));
+            }
+        }
+        sort(trigrams.begin(), trigrams.end());
+        trigrams.erase(unique(trigrams.begin(), trigrams.end()), trigrams.end());
+        return trigrams;
+    }
+};
+
+// Inverted index from the trigrams of a dictionary's values (case folded) to
+// their codes. Dictionary codes are never removed, so the index is extended
+// as the dictionary grows instead of being rebuilt.
+class TrigramIndex {
+private:
+    unordered_map<uint32_t, vector<uint32_t>> postings; // ascending codes
+    size_t indexed = 0;                                 // codes [0, indexed) are in postings
+
+public:
+    void update(const StringDictionary &dict) {
+        string value;
+        vector<uint32_t> keys;
+        for (; indexed < dict.size(); indexed++) {
+            const string &entry = dict.valueOf(static_cast<uint32_t>(indexed));
+            value.resize(entry.size());
+            for (size_t i = 0; i < entry.size(); i++)
+                value[i] = foldCase(entry[i]);
+            keys.clear();
+            for (size_t i = 0; i + 3 <= value.size(); i++)
+                keys.push_back(trigramKey(value.data() + i));
+            sort(keys.begin(), keys.end());
+            keys.erase(unique(keys.begin(), keys.end()), keys.end());
+            for (uint32_t key : keys)
+                postings[key].push_back(static_cast<uint32_t>(indexed));
+        }
+    }
+    // Codes of the values holding every one of the trigrams (at least one).
+    vector<uint32_t> candidates(const vector<uint32_t> &trigrams) const {
+        vector<const vector<uint32_t> *> lists;
+        for (uint32_t key : trigrams) {
+            auto it = postings.find(key);
+            if (it == postings.end())
+                return {};
+            lists.push_back(&it->second);
+        }
+        sort(lists.begin(), lists.end(),
+             [](const vector<uint32_t> *a, const vector<uint32_t> *b) { return a->size() < b->size(); });
+        vector<uint32_t> result = *lists[0], next;
+        for (size_t l = 1; l < lists.size() && !result.empty(); l++) {
+            next.clear();
+            set_intersection(result.begin(), result.end(), lists[l]->begin(), lists[l]->end(), back_inserter(next));
+            result.swap(next);
+        }
+        return result;
+    }
+};
@@ -82,6 +82,8 @@ std::string aesKey = "";
 Table* currentTableInstance = nullptr;
 bool exitProgram = false;
 int incorrectAttempts = 0;
+// Set by --metrics-file: the Prometheus dump is rewritten there after every command.
+std::string metricsFile = "";
 // Derive 256-bit AES key from raw password
 std::string deriveAESKey(const std::string& hashedInput) {
     std::string key = sha256WithSalt(hashedInput, "heyItsqilo");
@@ -93,46 +95,45 @@ std::string deriveAESKey(const std::string& hashedInput) {
 }
 
 void rotateEncryption(const std::string& oldKey, const std::string& newKey) {
+    // Files are listed first: each one is replaced by a renamed new file,
+    // which a directory walk in progress could visit again.
+    std::vector<fs::path> tableFiles;
+    std::vector<fs::path> catalogs{fs::path(fs_path) / CATALOG_FILE};
     for (auto& dbEntry : fs::directory_iterator(fs_path)) {
         if (!dbEntry.is_directory()) continue;
+        catalogs.push_back(dbEntry.path() / CATALOG_FILE);
 
         for (auto& fileEntry : fs::directory_iterator(dbEntry.path())) {
             if (!fileEntry.is_regular_file()) continue;
             if (fileEntry.path().extension() != ".bin")   // <<---- only rotate your encrypted tables
                 continue;
-
-            // Read IV + ciphertext
-            std::ifstream in(fileEntry.path(), std::ios::binary);
-            std::string iv(AES_BLOCK_SIZE, '\0');
-            in.read(&iv[0], AES_BLOCK_SIZE);
-            std::string cipherText{ std::istreambuf_iterator<char>(in),
-                                     std::istreambuf_iterator<char>() };
-            in.close();
-
-            // Decrypt & re‑encrypt under try/catch so one bad file won’t abort everything
-            try {
-                std::string savedKey = aesKey;
-
-                aesKey = oldKey;
-                std::string plain = aesDecrypt(cipherText, iv);
-                aesKey = newKey;
-                std::string newIv;
-                std::string newCipher = aesEncrypt(plain, newIv);
-
-                std::ofstream out(fileEntry.path(), std::ios::binary | std::ios::trunc);
-                out.write(newIv.data(), newIv.size());
-                out.write(newCipher.data(), newCipher.size());
-                out.close();
-
-                aesKey = savedKey;
-            } 
-            catch (const std::exception &e) {
-                std::cerr << "Warning: could not rotate "
-                          << fileEntry.path().filename().string()
-                          << " — " << e.what() << "\n";
-            }
+            tableFiles.push_back(fileEntry.path());
+        }
+    }
+    SyncGroup group;
+    for (const auto& tableFile : tableFiles) {
+        // Decrypt & re‑encrypt under try/catch so one bad file won’t abort everything
+        try {
+            rotateTableFileKey(tableFile, oldKey, newKey);
+        } 
+        catch (const std::exception &e) {
+            std::cerr << "Warning: could not rotate "
+                      << tableFile.filename().string()
+                      << " — " << e.what() << "\n";
         }
     }
+    for (const auto& catalog : catalogs) {
+        try {
+            rotateCatalogKey(catalog, oldKey, newKey);
+        }
+        catch (const std::exception &e) {
+            std::cerr << "Warning: could not rotate "
+                      << catalog.string()
+                      << " — " << e.what() << "\n";
+        }
+    }
+    // The rotated files are on disk before pass.txt names the new key.
+    group.flush();
     // finally switch your global key so new sessions use the new one
     // aesKey = newKey;
 }
@@ -223,9 +224,7 @@ bool passwordForgot(){
     rotateEncryption(oldAESKey, newAESKey);
     // 5) Overwrite pass.txt with the new hash
     fs::path passFile = fs::path(getDBMSPath()).parent_path() / "pass.txt";
-    std::ofstream out(passFile, std::ios::trunc);
-    out << newPassHash;
-    out.close();
+    writeFileAtomically(passFile.string(), newPassHash);
 
     // 6) Switch your running key to the new one
     aesKey = newAESKey;
@@ -254,6 +253,13 @@ int main(int argc, char const *argv[])
         } else if (flag == "--forgot") {
             if(!passwordForgot()) return 1;
             else return 0;
+        } else if (flag == "--metrics-file") {
+            if (argc < 3) {
+                std::cerr << "--metrics-file needs a file path." << std::endl;
+                return 1;
+            }
+            // Resolved now, the working directory changes to the data folder below.
+            metricsFile = fs::absolute(argv[2]).string();
         }        
     }
     // --- End flag handling ---
@@ -290,12 +296,20 @@ int main(int argc, char const *argv[])
             list<string> tokens = input();
             if (!tokens.empty())
             {
+                auto started = ProfileClock::now();
+                queryProfile.reset();
                 // Split tokens by pipe ("|") symbol.
                 list<list<string>> queries = splitQueries(tokens);
                 for (auto &q : queries) {
                     Parser parser(q);
                     parser.parse();
                 }
+                if (timingEnabled && tokens.front() != TIMING) {
+                    double ms = elapsedMs(started) + queryProfile.tokenizeSeconds * 1000.0;
+                    cout << "Time: " << fixed << setprecision(3) << ms << " ms" << endl;
+                    cout.unsetf(ios::floatfield);
+                    cout << setprecision(6);
+                }
             }
         } catch (const std::runtime_error &e) {
             cerr << "\033[31m" << e.what() << "\033[0m" << endl << endl;
@@ -310,6 +324,13 @@ int main(int argc, char const *argv[])
         } catch (...) {
             cerr << "\033[31mUnknown Error occurred while processing query.\033[0m" << endl << endl;
         }
+        if (!metricsFile.empty()) {
+            try {
+                writeMetricsFile(metricsFile);
+            } catch (const std::runtime_error &e) {
+                cerr << "\033[31m" << e.what() << "\033[0m" << endl;
+            }
+        }
     }
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,322 @@
+#include <atomic>
+#include <cmath>
+#include <deque>
+#include <mutex>
+
+// Process-wide metrics for monitoring: counters, gauges and latency
+// histograms, shown by `stats` and exported in the Prometheus text format.
+// Metrics are registered once and never removed, so code keeps a reference to
+// the ones it updates; an update is a single relaxed atomic operation and is
+// safe to leave on in insertRow and the scan loops.
+
+class MetricCounter {
+private:
+    atomic<uint64_t> value{0};
+
+public:
+    void add(uint64_t n = 1) { value.fetch_add(n, memory_order_relaxed); }
+    uint64_t get() const { return value.load(memory_order_relaxed); }
+};
+
+class MetricGauge {
+private:
+    atomic<int64_t> value{0};
+
+public:
+    void set(int64_t v) { value.store(v, memory_order_relaxed); }
+    void add(int64_t n) { value.fetch_add(n, memory_order_relaxed); }
+    int64_t get() const { return value.load(memory_order_relaxed); }
+};
+
+// Latency histogram with log-linear microsecond buckets, as in HDR
+// histograms: values below 16 us get a bucket each, and every power of two
+// above is split into 16 equal sub-buckets, up to 2^32 us (about 71
+// minutes); the last bucket holds everything above that. A bucket spans at
+// most 1/16 of its values, so quantiles, reported as the upper bound of
+// their bucket, are within about 6% of the real value.
+class LatencyHistogram {
+public:
+    static const int SUB_BITS = 4;
+    static const int SUB_BUCKETS = 1 << SUB_BITS; // per power of two
+    static const int OCTAVES = 32 - SUB_BITS;     // powers of two from 2^SUB_BITS to 2^32 us
+    static const int BUCKETS = SUB_BUCKETS * (OCTAVES + 1) + 1;
+
+private:
+    atomic<uint64_t> buckets[BUCKETS] = {};
+    atomic<uint64_t> total{0};
+    atomic<uint64_t> sumMicros{0};
+    atomic<uint64_t> maxMicros{0};
+
+public:
+    static int bucketOf(uint64_t micros) {
+        if (micros < SUB_BUCKETS)
+            return static_cast<int>(micros);
+        int shift = 0; // micros >> shift is in [SUB_BUCKETS, 2 * SUB_BUCKETS)
+        while (shift < OCTAVES - 1 && (micros >> shift) >= 2 * SUB_BUCKETS)
+            shift++;
+        if ((micros >> shift) >= 2 * SUB_BUCKETS)
+            return BUCKETS - 1;
+        return SUB_BUCKETS * (shift + 1) + static_cast<int>((micros >> shift) - SUB_BUCKETS);
+    }
+    // Largest observation counted by bucket b, in seconds.
+    static double bucketBound(int b) {
+        if (b < SUB_BUCKETS)
+            return b / 1e6;
+        if (b == BUCKETS - 1)
+            return HUGE_VAL;
+        int shift = b / SUB_BUCKETS - 1;
+        uint64_t sub = static_cast<uint64_t>(b % SUB_BUCKETS);
+        return static_cast<double>(((SUB_BUCKETS + sub + 1) << shift) - 1) / 1e6;
+    }
+    // Whether bucket b ends a power of two; the Prometheus export lists
+    // only those bounds.
+    static bool endsOctave(int b) { return b % SUB_BUCKETS == SUB_BUCKETS - 1 && b < BUCKETS - 1; }
+
+    void observe(double seconds) {
+        uint64_t micros = seconds > 0 ? static_cast<uint64_t>(seconds * 1e6 + 0.5) : 0;
+        buckets[bucketOf(micros)].fetch_add(1, memory_order_relaxed);
+        total.fetch_add(1, memory_order_relaxed);
+        sumMicros.fetch_add(micros, memory_order_relaxed);
+        uint64_t seen = maxMicros.load(memory_order_relaxed);
+        while (seen < micros && !maxMicros.compare_exchange_weak(seen, micros, memory_order_relaxed)) {
+        }
+    }
+    uint64_t count() const { return total.load(memory_order_relaxed); }
+    uint64_t bucketCount(int b) const { return buckets[b].load(memory_order_relaxed); }
+    double sumSeconds() const { return sumMicros.load(memory_order_relaxed) / 1e6; }
+    double maxSeconds() const { return maxMicros.load(memory_order_relaxed) / 1e6; }
+    // Upper bound of the bucket holding the q-quantile, capped by the maximum.
+    double quantile(double q) const {
+        uint64_t n = count();
+        if (n == 0)
+            return 0;
+        uint64_t rank = static_cast<uint64_t>(q * n + 0.5);
+        if (rank < 1)
+            rank = 1;
+        uint64_t seen = 0;
+        for (int b = 0; b < BUCKETS; b++) {
+            seen += bucketCount(b);
+            if (seen >= rank)
+                return min(bucketBound(b), maxSeconds());
+        }
+        return maxSeconds();
+    }
+};
+
+// Measures the time until it goes out of scope into a histogram.
+class LatencyTimer {
+private:
+    LatencyHistogram &histogram;
+    ProfileClock::time_point started;
+
+public:
+    explicit LatencyTimer(LatencyHistogram &h) : histogram(h), started(ProfileClock::now()) {}
+    ~LatencyTimer() { histogram.observe(chrono::duration<double>(ProfileClock::now() - started).count()); }
+    LatencyTimer(const LatencyTimer &) = delete;
+    LatencyTimer &operator=(const LatencyTimer &) = delete;
+};
+
+enum MetricKind : uint8_t { METRIC_COUNTER, METRIC_GAUGE, METRIC_HISTOGRAM };
+
+struct MetricEntry {
+    string name;
+    string labels; // e.g. type="show", empty for none
+    string help;
+    MetricKind kind;
+    void *metric;
+};
+
+class MetricsRegistry {
+private:
+    mutex registering; // guards registration only, never updates
+    deque<MetricCounter> counters;
+    deque<MetricGauge> gauges;
+    deque<LatencyHistogram> histograms;
+    vector<MetricEntry> entries;
+
+    MetricEntry *find(const string &name, const string &labels) {
+        for (auto &e : entries) {
+            if (e.name == name && e.labels == labels)
+                return &e;
+        }
+        return nullptr;
+    }
+
+public:
+    MetricCounter &counter(const string &name, const string &help, const string &labels = "") {
+        lock_guard<mutex> guard(registering);
+        if (MetricEntry *e = find(name, labels))
+            return *static_cast<MetricCounter *>(e->metric);
+        counters.emplace_back();
+        entries.push_back({name, labels, help, METRIC_COUNTER, &counters.back()});
+        return counters.back();
+    }
+    MetricGauge &gauge(const string &name, const string &help, const string &labels = "") {
+        lock_guard<mutex> guard(registering);
+        if (MetricEntry *e = find(name, labels))
+            return *static_cast<MetricGauge *>(e->metric);
+        gauges.emplace_back();
+        entries.push_back({name, labels, help, METRIC_GAUGE, &gauges.back()});
+        return gauges.back();
+    }
+    LatencyHistogram &histogram(const string &name, const string &help, const string &labels = "") {
+        lock_guard<mutex> guard(registering);
+        if (MetricEntry *e = find(name, labels))
+            return *static_cast<LatencyHistogram *>(e->metric);
+        histograms.emplace_back();
+        entries.push_back({name, labels, help, METRIC_HISTOGRAM, &histograms.back()});
+        return histograms.back();
+    }
+    vector<MetricEntry> snapshot() {
+        lock_guard<mutex> guard(registering);
+        return entries;
+    }
+};
+
+MetricsRegistry &metricsRegistry() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+MetricCounter &bytesReadMetric = metricsRegistry().counter(
+    "qilodb_bytes_read_total", "Bytes read from table files.");
+MetricCounter &bytesWrittenMetric = metricsRegistry().counter(
+    "qilodb_bytes_written_total", "Bytes written to table files.");
+MetricCounter &bytesEncryptedMetric = metricsRegistry().counter(
+    "qilodb_bytes_encrypted_total", "Plaintext bytes encrypted with AES.");
+MetricCounter &bytesDecryptedMetric = metricsRegistry().counter(
+    "qilodb_bytes_decrypted_total", "Ciphertext bytes decrypted with AES.");
+MetricCounter &rowsInsertedMetric = metricsRegistry().counter(
+    "qilodb_rows_inserted_total", "Rows added by insert.");
+MetricCounter &rowsScannedMetric = metricsRegistry().counter(
+    "qilodb_rows_scanned_total", "Rows visited by table scans.");
+MetricCounter &zoneBlocksScannedMetric = metricsRegistry().counter(
+    "qilodb_zone_blocks_scanned_total", "Blocks a filtered scan had to read.");
+MetricCounter &zoneBlocksSkippedMetric = metricsRegistry().counter(
+    "qilodb_zone_blocks_skipped_total", "Blocks a filtered scan skipped using zone maps.");
+MetricCounter &fileSyncsMetric = metricsRegistry().counter(
+    "qilodb_file_syncs_total", "Files and directories flushed to the device by commits.");
+LatencyHistogram &commitLatencyMetric = metricsRegistry().histogram(
+    "qilodb_commit_seconds", "Time taken by commit.");
+LatencyHistogram &tableLoadMetric = metricsRegistry().histogram(
+    "qilodb_table_load_seconds", "Time taken to load a table from disk.");
+
+// Statements by command keyword; anything else is counted as "other".
+static const char *const STATEMENT_TYPES[] = {
+    INIT, MAKE, ERASE, CLEAN, DEL, CHANGE, INSERT, ENTER, CHOOSE, CLOSE, EXIT, HELP,
+    DESCRIBE, COMPRESS, LIST, SHOW, ROLLBACK, COMMIT, TIMING, PROFILE, STATS, SLOWLOG, PAGER, SYNC, "other"};
+static const size_t STATEMENT_TYPE_COUNT = sizeof(STATEMENT_TYPES) / sizeof(STATEMENT_TYPES[0]);
+
+vector<MetricCounter *> statementCounters = [] {
+    vector<MetricCounter *> counters;
+    for (const char *type : STATEMENT_TYPES) {
+        // Label values escape backslashes (\timing).
+        string value;
+        for (const char *c = type; *c; c++)
+            value += *c == '\\' ? string("\\\\") : string(1, *c);
+        counters.push_back(&metricsRegistry().counter("qilodb_statements_total", "Statements executed, by command.",
+                                                      "type=\"" + value + "\""));
+    }
+    return counters;
+}();
+
+void countStatement(const string &command) {
+    size_t i = 0;
+    while (i < STATEMENT_TYPE_COUNT - 1 && command != STATEMENT_TYPES[i])
+        i++;
+    statementCounters[i]->add();
+}
+
+// Prometheus text exposition format, version 0.0.4.
+string metricsPrometheusText() {
+    ostringstream out;
+    out << setprecision(12); // exact bucket bounds
+    // Samples of one metric have to be contiguous.
+    vector<MetricEntry> entries = metricsRegistry().snapshot();
+    stable_sort(entries.begin(), entries.end(),
+                [](const MetricEntry &a, const MetricEntry &b) { return a.name < b.name; });
+    string lastName;
+    for (const auto &e : entries) {
+        if (e.name != lastName) {
+            static const char *const kindNames[] = {"counter", "gauge", "histogram"};
+            out << "# HELP " << e.name << " " << e.help << "\n";
+            out << "# TYPE " << e.name << " " << kindNames[e.kind] << "\n";
+            lastName = e.name;
+        }
+        string braces = e.labels.empty() ? "" : "{" + e.labels + "}";
+        if (e.kind == METRIC_COUNTER) {
+            out << e.name << braces << " " << static_cast<MetricCounter *>(e.metric)->get() << "\n";
+        } else if (e.kind == METRIC_GAUGE) {
+            out << e.name << braces << " " << static_cast<MetricGauge *>(e.metric)->get() << "\n";
+        } else {
+            const LatencyHistogram &h = *static_cast<LatencyHistogram *>(e.metric);
+            string prefix = e.labels.empty() ? "" : e.labels + ",";
+            uint64_t cumulative = 0;
+            for (int b = 0; b < LatencyHistogram::BUCKETS - 1; b++) {
+                cumulative += h.bucketCount(b);
+                if (!LatencyHistogram::endsOctave(b))
+                    continue;
+                out << e.name << "_bucket{" << prefix << "le=\"" << LatencyHistogram::bucketBound(b) << "\"} "
+                    << cumulative << "\n";
+            }
+            out << e.name << "_bucket{" << prefix << "le=\"+Inf\"} " << h.count() << "\n";
+            out << e.name << "_sum" << braces << " " << h.sumSeconds() << "\n";
+            out << e.name << "_count" << braces << " " << h.count() << "\n";
+        }
+    }
+    return out.str();
+}
+
+// Writes the Prometheus dump to a temporary file and renames it over path, so
+// a collector never reads a half written file.
+void writeMetricsFile(const string &path) {
+    string temp = path + ".tmp";
+    {
+        ofstream out(temp, ios::trunc);
+        if (!out.is_open())
+            throw runtime_error("program_error: could not write metrics file " + path + ".");
+        out << metricsPrometheusText();
+        if (!out)
+            throw runtime_error("program_error: could not write metrics file " + path + ".");
+    }
+    std::error_code ec;
+    fs::rename(temp, path, ec);
+    if (ec)
+        throw runtime_error("program_error: could not write metrics file " + path + ".");
+}
+
+void printMetrics() {
+    auto percent = [](uint64_t part, uint64_t whole) {
+        return whole == 0 ? 0.0 : 100.0 * part / whole;
+    };
+    cout << "---------------------------------------------------------\n";
+    cout << "\033[33m" << setw(45) << left << "Metric" << "Value" << "\033[0m\n";
+    cout << "---------------------------------------------------------\n";
+    for (const auto &e : metricsRegistry().snapshot()) {
+        string label = e.name + (e.labels.empty() ? "" : "{" + e.labels + "}");
+        if (e.kind == METRIC_COUNTER) {
+            uint64_t v = static_cast<MetricCounter *>(e.metric)->get();
+            // Statement types that were never run only add noise.
+            if (v == 0 && !e.labels.empty())
+                continue;
+            cout << setw(45) << left << label << v << "\n";
+        } else if (e.kind == METRIC_GAUGE) {
+            cout << setw(45) << left << label << static_cast<MetricGauge *>(e.metric)->get() << "\n";
+        } else {
+            const LatencyHistogram &h = *static_cast<LatencyHistogram *>(e.metric);
+            cout << setw(45) << left << label << "count " << h.count() << fixed << setprecision(3)
+                 << ", p50 " << h.quantile(0.5) * 1000.0 << " ms"
+                 << ", p99 " << h.quantile(0.99) * 1000.0 << " ms"
+                 << ", max " << h.maxSeconds() * 1000.0 << " ms\n";
+            cout.unsetf(ios::floatfield);
+            cout << setprecision(6);
+        }
+    }
+    cout << "---------------------------------------------------------\n";
+    uint64_t scanned = zoneBlocksScannedMetric.get(), skipped = zoneBlocksSkippedMetric.get();
+    cout << setw(45) << left << "zone map skip rate" << fixed << setprecision(1)
+         << percent(skipped, scanned + skipped) << "%\n";
+    cout.unsetf(ios::floatfield);
+    cout << setprecision(6);
+    cout << "---------------------------------------------------------\n";
+}
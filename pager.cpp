@@ -0,0 +1,129 @@
+#include <functional>
+
+// Streaming output of `show` results. Matching rows are written as they are
+// found, a page at a time, instead of after a pass that sizes every column
+// over the whole table.
+
+static const size_t SHOW_PAGE_ROWS = 1024; // rows sized and written together
+size_t pagerRows = 0; // set by `\pager`: rows per screen, 0 never pauses
+
+// Column widths come from the header and the first page. A later page with
+// wider values prints the header again with the grown widths, so every
+// section stays aligned. With \pager set, output pauses after each screen
+// until the user asks for more or stops. Entry is what a result row is
+// read from: a table row, or the pair of rows of a join.
+template <typename Entry> class BasicResultPager {
+public:
+    using CellReader = function<const string &(const Entry &, size_t)>;
+
+private:
+    vector<string> header;
+    vector<size_t> widths;
+    CellReader cell;
+    size_t pageSize;
+    vector<const Entry *> page;
+    string out;
+    bool started = false; // header printed
+    bool paused = false;  // a full screen was printed, ask before the next row
+    bool stopped = false;
+
+    void appendBorder() {
+        for (size_t i = 0; i < widths.size(); i++) {
+            out += i == 0 ? "+-" : "-+-";
+            out.append(widths[i], '-');
+        }
+        out += "-+\n";
+    }
+    void appendHeader() {
+        out += "\n";
+        appendBorder();
+        for (size_t i = 0; i < header.size(); i++) {
+            size_t padding = widths[i] - header[i].length();
+            out += i == 0 ? "| " : " | ";
+            out += "\033[33m";
+            out.append(padding / 2, ' ');
+            out += header[i];
+            out.append(padding - padding / 2, ' ');
+            out += "\033[0m";
+        }
+        out += " |\n";
+        appendBorder();
+    }
+    void writePage() {
+        PhaseTimer formatting(PHASE_OUTPUT);
+        vector<size_t> needed = widths;
+        for (const Entry *row : page) {
+            for (size_t i = 0; i < needed.size(); i++)
+                needed[i] = max(needed[i], cell(*row, i).length());
+        }
+        if (started && needed != widths)
+            appendBorder(); // closes the section printed with the old widths
+        if (!started || needed != widths) {
+            widths = std::move(needed);
+            appendHeader();
+        }
+        started = true;
+        for (const Entry *row : page) {
+            for (size_t i = 0; i < widths.size(); i++) {
+                const string &value = cell(*row, i);
+                out += i == 0 ? "| " : " | ";
+                out += value;
+                out.append(widths[i] - value.length(), ' ');
+            }
+            out += " |\n";
+        }
+        page.clear();
+        cout << out;
+        out.clear();
+    }
+    // Asks whether to print the next screen; false when the user stops.
+    bool askForMore() {
+        cout << "\033[36m-- more: enter for the next " << pagerRows << " rows, q to stop --\033[0m" << std::flush;
+        string answer;
+        if (!getline(cin, answer))
+            return false;
+        return answer.empty() || (answer[0] != 'q' && answer[0] != 'Q');
+    }
+
+public:
+    BasicResultPager(vector<string> columns, CellReader reader)
+        : header(std::move(columns)), cell(std::move(reader)), pageSize(pagerRows ? pagerRows : SHOW_PAGE_ROWS) {
+        for (const string &name : header)
+            widths.push_back(name.length());
+    }
+    bool stoppedByUser() const { return stopped; }
+    // Queues a row for output; false once the user has stopped the listing.
+    bool add(const Entry &row) {
+        if (stopped)
+            return false;
+        if (paused) {
+            paused = false;
+            if (!askForMore()) {
+                stopped = true;
+                return false;
+            }
+        }
+        page.push_back(&row);
+        if (page.size() == pageSize) {
+            writePage();
+            paused = pagerRows > 0;
+        }
+        return true;
+    }
+    // Writes the rows queued so far, for entries that do not outlive the
+    // caller's buffer.
+    void flush() {
+        if (!page.empty())
+            writePage();
+    }
+    // Writes the rows still queued and the closing border.
+    void finish() {
+        if (!page.empty() || !started)
+            writePage();
+        PhaseTimer formatting(PHASE_OUTPUT);
+        appendBorder();
+        cout << out;
+        out.clear();
+    }
+};
+typedef BasicResultPager<Row> ResultPager;
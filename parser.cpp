@@ -9,6 +9,7 @@ extern bool exitProgram;  // Declaration of the global variable
 
 // Global pointer to the current Table instance.
 extern Table* currentTableInstance;
+#include "slowlog.cpp"
 void exitTable() {
     // If there are unsaved changes, ask the user whether to save.
     if (currentTableInstance->unsavedChanges) {
@@ -37,8 +38,25 @@ private:
         checkExtraTokens();
         init_database(dbName);
     }
+    void processFulltextIndex() {
+        // MAKE FULLTEXT INDEX ON <column_name>
+        if (!currentTableInstance) {
+            throw logic_error("MAKE FULLTEXT INDEX -> can only be used in table.");
+        }
+        queryList.pop_front();
+        if (getCommand() != INDEX || getCommand() != ON) {
+            throw ("syntax_error: MAKE FULLTEXT -> expected MAKE FULLTEXT INDEX ON <column>.");
+        }
+        string column = getCommand();
+        checkExtraTokens();
+        currentTableInstance->createFulltextIndex(column);
+    }
     void processMake() {
         // MAKE <table_name> [ ( <column_definitions> ) ]
+        if (!queryList.empty() && queryList.front() == FULLTEXT) {
+            processFulltextIndex();
+            return;
+        }
         if(currentDatabase.empty() || !currentTable.empty()){
             throw logic_error("MAKE -> not used before entering a database / within a table .");
         }
@@ -47,6 +65,8 @@ private:
         if(tableName[0] == ' ' || tableName[tableName.size() - 1] == ' '){
             throw invalid_argument("Table name cannot start/end with <space>");
         }
+        // The table file and the catalog share one directory flush.
+        SyncGroup group;
         // Call the free function make_table with only the header definitions.
         make_table(queryList, tableName);
         // After creation, currentTable should be set by make_table.
@@ -61,6 +81,7 @@ private:
             currentTableInstance = new Table(currentTable);
             currentTableInstance->updateMetaFile();
         }
+        group.flush();
     }    
     void processErase() {
         // ERASE <database or table name>
@@ -75,7 +96,7 @@ private:
         // Inside a database: erase a table.
         else {
             eraseTable(name);
-            removeTableMetadataEntry(name);
+            catalogRemoveTable(name);
             if (currentTable == name)
                 currentTable = "";
             if (currentTableInstance) { //////////////    TABLE INSTANCE IS HERE
@@ -150,6 +171,15 @@ private:
             }
         }
     }
+    void processCompress() {
+        // COMPRESS <codec>
+        if (!currentTableInstance) {
+            throw logic_error("COMPRESS -> can only be used in table.");
+        }
+        string codec = getCommand();
+        checkExtraTokens();
+        currentTableInstance->setCodec(parseCodec(codec));
+    }
     void processDescribe(){
         if (currentTable.empty()) {
             throw logic_error("DESCRIBE -> can only be used in table");
@@ -310,10 +340,54 @@ private:
             throw logic_error("LIST -> not available in table.");
         }
     }
+    // SHOW <cols> FROM <table> JOIN <table> ON <col> = <col> [WHERE ...]
+    void processJoin() {
+        if (currentDatabase.empty())
+            throw logic_error("SHOW -> a join can only be used inside a database.");
+        vector<string> select;
+        while (queryList.front() != FROM) {
+            select.push_back(queryList.front());
+            queryList.pop_front();
+        }
+        queryList.pop_front(); // FROM
+        if (queryList.size() < 3 || *next(queryList.begin()) != JOIN)
+            throw ("syntax_error: SHOW -> expected FROM <table> JOIN <table>.");
+        string names[2];
+        names[0] = getCommand();
+        queryList.pop_front(); // JOIN
+        names[1] = getCommand();
+        vector<string> clauses(queryList.begin(), queryList.end());
+        queryList.clear();
+        if (names[0] == names[1])
+            throw logic_error("SHOW -> a table cannot be joined with itself.");
+        // The open table is joined as it is in memory, unsaved changes included.
+        unique_ptr<Table> opened[2];
+        Table *tables[2];
+        for (int i = 0; i < 2; i++) {
+            if (currentTableInstance && names[i] == currentTable) {
+                tables[i] = currentTableInstance;
+                continue;
+            }
+            if (!ifstream(names[i] + ".bin").good())
+                throw logic_error("table \"" + names[i] + "\" does not exist.");
+            opened[i].reset(new Table(names[i]));
+            tables[i] = opened[i].get();
+        }
+        Table::showJoin(*tables[0], *tables[1], select, clauses);
+    }
     void processShow() {
+        if (find(queryList.begin(), queryList.end(), FROM) != queryList.end()) {
+            processJoin();
+            return;
+        }
         string params;
         while (!queryList.empty()) {
-            params += queryList.front() + " ";
+            const string &token = queryList.front();
+            // Quoted text with spaces is quoted again so show() keeps it in one token.
+            if (token.find(' ') != string::npos)
+                params += (token.find('\'') == string::npos ? "'" + token + "'" : "\"" + token + "\"") + " ";
+            else
+                params += token + " ";
             queryList.pop_front();
         }
         if (!params.empty())
@@ -331,6 +405,135 @@ private:
             throw logic_error("No table selected for transaction ROLLBACK.");
     }
 
+    void processTiming() {
+        // \TIMING [ON|OFF]; without an argument it toggles.
+        if (queryList.empty()) {
+            timingEnabled = !timingEnabled;
+        } else {
+            string mode = getCommand();
+            checkExtraTokens();
+            if (mode == "on")
+                timingEnabled = true;
+            else if (mode == "off")
+                timingEnabled = false;
+            else
+                throw ("syntax_error: \\timing -> expected on or off, got \"" + mode + "\".");
+        }
+        cout << "\033[32mres: Timing is " << (timingEnabled ? "on" : "off") << ".\033[0m" << endl;
+    }
+
+    void processProfile() {
+        // PROFILE <statement>: runs the statement with phase timers enabled.
+        if (queryList.empty()) {
+            throw ("syntax_error: PROFILE -> missing statement.");
+        }
+        if (queryList.front() == PROFILE || queryList.front() == TIMING) {
+            throw ("syntax_error: PROFILE -> cannot profile \"" + queryList.front() + "\".");
+        }
+        list<string> statement(queryList.begin(), queryList.end());
+        queryList.clear();
+
+        double tokenizeSeconds = queryProfile.tokenizeSeconds;
+        queryProfile.reset();
+        queryProfile.enabled = true;
+        uint64_t allocationsBefore = allocationCount.load(memory_order_relaxed);
+        auto started = ProfileClock::now();
+        try {
+            PhaseTimer parsing(PHASE_PARSE);
+            Parser(statement).parse();
+        } catch (...) {
+            queryProfile.enabled = false;
+            throw;
+        }
+        queryProfile.enabled = false;
+        queryProfile.phaseSeconds[PHASE_PARSE] += tokenizeSeconds;
+        double wallMs = elapsedMs(started) + tokenizeSeconds * 1000.0;
+        printProfile(wallMs, allocationCount.load(memory_order_relaxed) - allocationsBefore);
+    }
+
+    void processSlowLog() {
+        // \SLOWLOG [<ms>|OFF]; without an argument it shows the setting.
+        if (!queryList.empty()) {
+            string mode = getCommand();
+            checkExtraTokens();
+            if (mode == "off") {
+                slowQueryLog.disable();
+            } else {
+                double ms;
+                try {
+                    size_t used = 0;
+                    ms = stod(mode, &used);
+                    if (used != mode.size() || ms < 0)
+                        throw invalid_argument(mode);
+                } catch (const logic_error &) {
+                    throw ("syntax_error: \\slowlog -> expected a threshold in ms or off, got \"" + mode + "\".");
+                }
+                slowQueryLog.enable(ms);
+            }
+        }
+        if (slowQueryLog.enabled())
+            cout << "\033[32mres: Logging statements taking " << slowQueryLog.thresholdMs << " ms or more to "
+                 << slowQueryLog.logPath() << ".\033[0m" << endl;
+        else
+            cout << "\033[32mres: Slow query log is off.\033[0m" << endl;
+    }
+
+    void processPager() {
+        // \PAGER [<rows>|OFF]; without an argument it shows the setting.
+        if (!queryList.empty()) {
+            string mode = getCommand();
+            checkExtraTokens();
+            if (mode == "off") {
+                pagerRows = 0;
+            } else {
+                int rows = 0;
+                try {
+                    size_t used = 0;
+                    rows = stoi(mode, &used);
+                    if (used != mode.size() || rows <= 0)
+                        throw invalid_argument(mode);
+                } catch (const logic_error &) {
+                    throw ("syntax_error: \\pager -> expected a number of rows or off, got \"" + mode + "\".");
+                }
+                pagerRows = static_cast<size_t>(rows);
+            }
+        }
+        if (pagerRows > 0)
+            cout << "\033[32mres: Show output pauses every " << pagerRows << " rows.\033[0m" << endl;
+        else
+            cout << "\033[32mres: Pager is off.\033[0m" << endl;
+    }
+
+    void processSync() {
+        // \SYNC [FULL|NORMAL|OFF]; without an argument it shows the setting.
+        if (!queryList.empty()) {
+            string mode = getCommand();
+            checkExtraTokens();
+            syncMode = parseSyncMode(mode);
+        }
+        cout << "\033[32mres: Sync mode is " << syncModeName(syncMode) << ".\033[0m" << endl;
+    }
+
+    void processStats() {
+        // STATS [PROMETHEUS | EXPORT [file]]
+        if (queryList.empty()) {
+            printMetrics();
+            return;
+        }
+        string mode = getCommand();
+        if (mode == "prometheus") {
+            checkExtraTokens();
+            cout << metricsPrometheusText();
+        } else if (mode == "export") {
+            string path = queryList.empty() ? (fs::path(fs_path) / "metrics.prom").string() : getCommand();
+            checkExtraTokens();
+            writeMetricsFile(path);
+            cout << "\033[32mres: Metrics written to " << path << ".\033[0m" << endl;
+        } else {
+            throw ("syntax_error: STATS -> expected prometheus or export, got \"" + mode + "\".");
+        }
+    }
+
     void processCommit() {
         if (currentTableInstance)
             currentTableInstance->commitTransaction();
@@ -357,7 +560,9 @@ public:
     // The parse method processes all tokens.
     void parse() {
         while (!queryList.empty()) {
+                SlowQueryTimer timing(queryList);
                 string query = getCommand();
+                countStatement(query);
     
                 if (query == INIT) {
                     processInit();
@@ -402,6 +607,9 @@ public:
                 else if (query == DESCRIBE) {
                     processDescribe();
                 }
+                else if (query == COMPRESS) {
+                    processCompress();
+                }
                 else if (query == LIST) {
                     processList();
                 }
@@ -414,6 +622,24 @@ public:
                 else if (query == COMMIT) {
                     processCommit();
                 }
+                else if (query == TIMING) {
+                    processTiming();
+                }
+                else if (query == PROFILE) {
+                    processProfile();
+                }
+                else if (query == STATS) {
+                    processStats();
+                }
+                else if (query == SLOWLOG) {
+                    processSlowLog();
+                }
+                else if (query == PAGER) {
+                    processPager();
+                }
+                else if (query == SYNC) {
+                    processSync();
+                }
                 else {
                     throw ("syntax_error: unknown query " + query );
                 }
@@ -425,10 +651,9 @@ public:
 };
 
 /*     Done    */
-list<string> input() {
-    string inputStr;
-    getline(cin, inputStr);
-
+// Splits one command line into tokens.
+list<string> tokenize(const string &inputStr) {
+    auto started = ProfileClock::now();
     list<string> query;
     string word = "";
     bool s_quotation = false, d_quotation = false;
@@ -489,10 +714,20 @@ list<string> input() {
                 case '<':
                 case '>':
                 case '*':
+                case '%':
                 case '!':
                 case '.':
                 case '~':
+                    // Kept inside quotes as well, e.g. a file name or '3.5'.
+                    word.push_back(ch);
+                    break;
+                case '\\':
+                    // Only meta commands such as \timing start with a backslash.
                     if (!s_quotation && !d_quotation) {
+                        if (!word.empty())
+                            throw ("syntax_error: \\ is not expected.");
+                        word.push_back(ch);
+                    } else {
                         word.push_back(ch);
                     }
                     break;
@@ -524,11 +759,15 @@ list<string> input() {
     if (inside_parentheses){
         throw ("syntax_error: Mismatched parentheses in input.");
     }
+    queryProfile.tokenizeSeconds = chrono::duration<double>(ProfileClock::now() - started).count();
 // Comment out below lines, For debugging: print tokens
     // for (const string &token : query) {
     //     cout << token << endl;
     // }
     return query;
 }
-
-
+list<string> input() {
+    string inputStr;
+    getline(cin, inputStr);
+    return tokenize(inputStr);
+}
@@ -0,0 +1,132 @@
+// Ordered index of an INT/BIGINT primary key. Entries live in a sorted array;
+// keys appended in ascending order (the usual auto-increment case) extend it
+// directly, other inserts go to a small sorted delta that is merged into the
+// array once it fills up. Erased array entries are tombstoned and dropped by
+// the next merge, so neither inserts nor erases move the whole array.
+
+class PrimaryIndex {
+public:
+    struct Entry {
+        int64_t key;
+        Row *row; // nullptr for an erased entry
+    };
+
+private:
+    static const size_t DELTA_MAX = 1024;
+    vector<Entry> base;  // sorted by key
+    vector<Entry> delta; // sorted by key, never tombstoned
+    size_t tombstones = 0;
+
+    static bool keyBefore(const Entry &e, int64_t key) { return e.key < key; }
+
+    void mergeDelta() {
+        vector<Entry> merged;
+        merged.reserve(base.size() - tombstones + delta.size());
+        auto b = base.begin(), d = delta.begin();
+        while (b != base.end() || d != delta.end()) {
+            if (b != base.end() && !b->row) {
+                ++b;
+            } else if (d == delta.end() || (b != base.end() && b->key <= d->key)) {
+                merged.push_back(*b++);
+            } else {
+                merged.push_back(*d++);
+            }
+        }
+        base = std::move(merged);
+        delta.clear();
+        tombstones = 0;
+    }
+
+public:
+    void clear() {
+        base.clear();
+        delta.clear();
+        tombstones = 0;
+    }
+    // Replaces the contents with the given entries, in any order.
+    void build(vector<Entry> entries) {
+        stable_sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) { return a.key < b.key; });
+        base = std::move(entries);
+        delta.clear();
+        tombstones = 0;
+    }
+    size_t size() const { return base.size() - tombstones + delta.size(); }
+
+    void insert(int64_t key, Row *row) {
+        if (delta.empty() && (base.empty() || base.back().key < key)) {
+            base.push_back({key, row});
+            return;
+        }
+        delta.insert(lower_bound(delta.begin(), delta.end(), key, keyBefore), {key, row});
+        if (delta.size() >= DELTA_MAX)
+            mergeDelta();
+    }
+    Row *find(int64_t key) const {
+        auto b = lower_bound(base.begin(), base.end(), key, keyBefore);
+        for (; b != base.end() && b->key == key; ++b) {
+            if (b->row)
+                return b->row;
+        }
+        auto d = lower_bound(delta.begin(), delta.end(), key, keyBefore);
+        return d != delta.end() && d->key == key ? d->row : nullptr;
+    }
+    void erase(int64_t key, const Row *row) {
+        auto d = lower_bound(delta.begin(), delta.end(), key, keyBefore);
+        for (; d != delta.end() && d->key == key; ++d) {
+            if (d->row == row) {
+                delta.erase(d);
+                return;
+            }
+        }
+        auto b = lower_bound(base.begin(), base.end(), key, keyBefore);
+        for (; b != base.end() && b->key == key; ++b) {
+            if (b->row == row) {
+                b->row = nullptr;
+                if (++tombstones > base.size() / 2)
+                    mergeDelta();
+                return;
+            }
+        }
+    }
+    // Largest key, or false when the index is empty.
+    bool maxKey(int64_t &key) const {
+        bool found = false;
+        for (auto b = base.rbegin(); b != base.rend(); ++b) {
+            if (b->row) {
+                key = b->key;
+                found = true;
+                break;
+            }
+        }
+        if (!delta.empty() && (!found || delta.back().key > key)) {
+            key = delta.back().key;
+            found = true;
+        }
+        return found;
+    }
+    // Entries with low <= key <= high; an estimate, erased entries included.
+    size_t countInRange(int64_t low, int64_t high) const {
+        if (low > high)
+            return 0;
+        auto span = [&](const vector<Entry> &entries) {
+            auto first = lower_bound(entries.begin(), entries.end(), low, keyBefore);
+            auto last = upper_bound(entries.begin(), entries.end(), high,
+                                    [](int64_t key, const Entry &e) { return key < e.key; });
+            return static_cast<size_t>(last - first);
+        };
+        return span(base) + span(delta);
+    }
+    // Calls visit(row) for every entry with low <= key <= high: the array
+    // entries in key order, then those of the delta.
+    template <typename Visit>
+    void forEachInRange(int64_t low, int64_t high, Visit visit) const {
+        if (low > high)
+            return;
+        for (auto b = lower_bound(base.begin(), base.end(), low, keyBefore); b != base.end() && b->key <= high; ++b) {
+            if (b->row)
+                visit(b->row);
+        }
+        for (auto d = lower_bound(delta.begin(), delta.end(), low, keyBefore); d != delta.end() && d->key <= high; ++d)
+            visit(d->row);
+    }
+};
@@ -0,0 +1,136 @@
+#include <atomic>
+#include <chrono>
+#include <new>
+
+// Statement profiling for `\timing` and `profile <statement>`.
+// Row and byte counters are always kept (plain increments); phase timers only
+// read the clock while a profile is running. Phase time is exclusive: when a
+// phase starts inside another one, the outer phase stops accumulating until
+// the inner one ends, so the phases add up to the statement's wall time.
+
+enum ProfilePhase : int {
+    PHASE_PARSE,
+    PHASE_CONDITIONS,
+    PHASE_SCAN,
+    PHASE_SORT,
+    PHASE_JOIN,
+    PHASE_OUTPUT,
+    PHASE_LOAD_IO,
+    PHASE_COMMIT_IO,
+    PHASE_COUNT
+};
+static const char *const PROFILE_PHASE_NAMES[PHASE_COUNT] = {
+    "parse", "conditions", "scan", "sort", "join", "output", "load i/o", "commit i/o"};
+
+typedef chrono::steady_clock ProfileClock;
+
+// Heap allocations made by the process, read before and after a statement.
+// Counting them replaces the global operator new, so only builds that define
+// QILO_COUNT_ALLOCATIONS (the microbenchmarks, profiling builds) do it; in
+// other builds the count stays 0 and `profile` reports it as unavailable.
+atomic<uint64_t> allocationCount{0};
+
+#ifdef QILO_COUNT_ALLOCATIONS
+static const bool ALLOCATIONS_COUNTED = true;
+
+void *operator new(size_t size) {
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    if (void *p = malloc(size ? size : 1))
+        return p;
+    throw bad_alloc();
+}
+// GCC flags the free() of memory from operator new once these are inlined,
+// although this operator new allocates with malloc().
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpragmas"
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#else
+static const bool ALLOCATIONS_COUNTED = false;
+#endif
+
+struct QueryProfile {
+    bool enabled = false;           // true while `profile` runs a statement
+    double phaseSeconds[PHASE_COUNT] = {};
+    uint64_t rowsScanned = 0;       // rows visited by a scan
+    uint64_t rowsMatched = 0;       // rows that passed the statement's filter
+    uint64_t bytesDecrypted = 0;
+    double tokenizeSeconds = 0;     // time the last tokenize() call took
+    int currentPhase = -1;          // innermost running phase, -1 for none
+    ProfileClock::time_point phaseStart;
+
+    void reset() {
+        for (double &s : phaseSeconds)
+            s = 0;
+        rowsScanned = rowsMatched = bytesDecrypted = 0;
+        currentPhase = -1;
+    }
+    // Charges the time since the last switch to the running phase.
+    void charge(ProfileClock::time_point now) {
+        if (currentPhase >= 0)
+            phaseSeconds[currentPhase] += chrono::duration<double>(now - phaseStart).count();
+        phaseStart = now;
+    }
+};
+QueryProfile queryProfile;
+bool timingEnabled = false; // toggled by `\timing`
+
+// Attributes the time until it goes out of scope to a phase.
+class PhaseTimer {
+private:
+    bool active;
+    int previousPhase = -1;
+
+public:
+    explicit PhaseTimer(ProfilePhase phase) : active(queryProfile.enabled) {
+        if (!active)
+            return;
+        queryProfile.charge(ProfileClock::now());
+        previousPhase = queryProfile.currentPhase;
+        queryProfile.currentPhase = phase;
+    }
+    ~PhaseTimer() {
+        if (!active)
+            return;
+        queryProfile.charge(ProfileClock::now());
+        queryProfile.currentPhase = previousPhase;
+    }
+    PhaseTimer(const PhaseTimer &) = delete;
+    PhaseTimer &operator=(const PhaseTimer &) = delete;
+};
+
+double elapsedMs(ProfileClock::time_point start) {
+    return chrono::duration<double, milli>(ProfileClock::now() - start).count();
+}
+
+void printProfile(double wallMs, uint64_t allocations) {
+    double phasesMs = 0;
+    cout << "---------------------------------------\n";
+    cout << "\033[33m" << setw(20) << left << "Phase" << "Time (ms)" << "\033[0m\n";
+    cout << "---------------------------------------\n";
+    cout << fixed << setprecision(3);
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        double ms = queryProfile.phaseSeconds[p] * 1000.0;
+        phasesMs += ms;
+        cout << setw(20) << left << PROFILE_PHASE_NAMES[p] << ms << "\n";
+    }
+    cout << setw(20) << left << "other" << max(0.0, wallMs - phasesMs) << "\n";
+    cout << "---------------------------------------\n";
+    cout << setw(20) << left << "Wall time" << wallMs << " ms\n";
+    cout.unsetf(ios::floatfield);
+    cout << setprecision(6);
+    cout << setw(20) << left << "Rows scanned" << queryProfile.rowsScanned << "\n";
+    cout << setw(20) << left << "Rows matched" << queryProfile.rowsMatched << "\n";
+    cout << setw(20) << left << "Bytes decrypted" << queryProfile.bytesDecrypted << "\n";
+    if (ALLOCATIONS_COUNTED)
+        cout << setw(20) << left << "Allocations" << allocations << "\n";
+    else
+        cout << setw(20) << left << "Allocations" << "unavailable (build with -DQILO_COUNT_ALLOCATIONS)\n";
+    cout << "---------------------------------------\n";
+}
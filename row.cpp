@@ -2,13 +2,15 @@ class Row {
 public:
     string id;
     vector<string> values;
+    // Dictionary codes for CHAR/VARCHAR/STRING columns (see StringDictionary).
+    vector<uint32_t> codes;
+    uint64_t sequence = 0; // insertion order, see Table::rebuildPrimaryIndex
 
     // Default constructor
-    Row() : id(""), values() {}
+    Row() : id(""), values(), codes() {}
 
     // Parameterized constructor
-    Row(const string &id, const vector<string> &values) : id(id), values(values) {}
+    Row(const string &id, const vector<string> &values) : id(id), values(values), codes() {}
 
     ~Row() {}
 };
-
@@ -0,0 +1,73 @@
+// Column descriptor built once from the table header.
+// Constraints are decoded into flags and the DEFAULT value is validated up
+// front, so an insert only tests bits instead of reparsing constraint strings.
+
+enum ColumnFlag : uint8_t {
+    COLUMN_PRIMARY = 1,
+    COLUMN_NOT_NULL = 2,
+    COLUMN_UNIQUE = 4,
+    COLUMN_AUTO_INCREMENT = 8,
+    COLUMN_FULLTEXT = 16 // has a full-text index, see fulltext.cpp
+};
+
+struct ColumnSchema {
+    string name;
+    string typeName;             // data type as written in the header
+    DataType type = TYPE_UNKNOWN;
+    vector<string> constraints;  // constraints as written, e.g. "DEFAULT#in"
+    uint8_t flags = 0;
+    bool hasDefault = false;
+    bool defaultValid = false;   // whether defaultValue passes the type check
+    string defaultValue;
+    ValueValidator validator = nullptr;
+    bool numeric = false;
+    // Row layout (see Table::buildCellLayout): an index into Row::codes for
+    // dictionary encoded columns, into Row::values otherwise, -1 for the primary key.
+    bool dictEncoded = false;
+    int slot = -1;
+
+    bool has(ColumnFlag flag) const { return (flags & flag) != 0; }
+
+    // Constraints joined by commas, as shown by describe.
+    string constraintList() const {
+        string joined;
+        for (size_t i = 0; i < constraints.size(); i++) {
+            if (i > 0)
+                joined += ",";
+            joined += constraints[i];
+        }
+        return joined;
+    }
+
+    static ColumnSchema parse(const string &name, const string &typeName, const vector<string> &constraints) {
+        ColumnSchema column;
+        column.name = name;
+        column.typeName = typeName;
+        column.type = parseDataType(typeName);
+        column.validator = validatorFor(column.type);
+        column.numeric = isNumericType(column.type);
+        column.constraints = constraints;
+        for (const string &c : constraints) {
+            if (c == "PRIMARY")
+                column.flags |= COLUMN_PRIMARY;
+            else if (c == "NOT_NULL")
+                column.flags |= COLUMN_NOT_NULL;
+            else if (c == "UNIQUE")
+                column.flags |= COLUMN_UNIQUE;
+            else if (c == "AUTO_INCREMENT")
+                column.flags |= COLUMN_AUTO_INCREMENT;
+            else if (c == "FULLTEXT")
+                column.flags |= COLUMN_FULLTEXT;
+            else if (c.compare(0, 7, "DEFAULT") == 0) {
+                // Stored as DEFAULT#value; a bare DEFAULT has no value.
+                size_t pos = c.find('#');
+                if (pos != string::npos && pos + 1 < c.size()) {
+                    column.hasDefault = true;
+                    column.defaultValue = c.substr(pos + 1);
+                    column.defaultValid = validateCell(column.validator, column.defaultValue);
+                }
+            }
+        }
+        return column;
+    }
+};
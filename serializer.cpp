@@ -0,0 +1,68 @@
+#include <cstdint>
+#include <cstring>
+
+// Little-endian binary encoding helpers used by the table storage format.
+class ByteWriter {
+public:
+    string buffer;
+
+    void putU8(uint8_t v) { buffer.push_back(static_cast<char>(v)); }
+    void putU32(uint32_t v) {
+        for (int i = 0; i < 4; i++)
+            buffer.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+    }
+    void putU64(uint64_t v) {
+        for (int i = 0; i < 8; i++)
+            buffer.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+    }
+    void putBytes(const char *data, size_t len) { buffer.append(data, len); }
+    // Length-prefixed string.
+    void putString(const string &s) {
+        putU32(static_cast<uint32_t>(s.size()));
+        buffer.append(s);
+    }
+};
+
+class ByteReader {
+private:
+    const string &buffer;
+    size_t pos;
+
+    void need(size_t n) const {
+        if (buffer.size() - pos < n)
+            throw runtime_error("program_error: table data is truncated or corrupted.");
+    }
+
+public:
+    ByteReader(const string &buf, size_t start = 0) : buffer(buf), pos(start) {}
+
+    uint8_t getU8() {
+        need(1);
+        return static_cast<uint8_t>(buffer[pos++]);
+    }
+    uint32_t getU32() {
+        need(4);
+        uint32_t v = 0;
+        for (int i = 0; i < 4; i++)
+            v |= static_cast<uint32_t>(static_cast<unsigned char>(buffer[pos + i])) << (8 * i);
+        pos += 4;
+        return v;
+    }
+    uint64_t getU64() {
+        need(8);
+        uint64_t v = 0;
+        for (int i = 0; i < 8; i++)
+            v |= static_cast<uint64_t>(static_cast<unsigned char>(buffer[pos + i])) << (8 * i);
+        pos += 8;
+        return v;
+    }
+    string getString() {
+        uint32_t len = getU32();
+        need(len);
+        string s = buffer.substr(pos, len);
+        pos += len;
+        return s;
+    }
+    size_t position() const { return pos; }
+    bool atEnd() const { return pos >= buffer.size(); }
+};
@@ -0,0 +1,218 @@
+#include <condition_variable>
+#include <ctime>
+#include <thread>
+
+// Slow query log: statements that take at least `\slowlog <ms>` are appended
+// to <fs_path>/slow.log. The command loop only measures the statement and
+// hands an entry to a background writer through a lock-free ring; formatting
+// and file I/O happen on the writer thread, so logging does not add to the
+// time of the statement being logged.
+
+struct SlowQueryEntry {
+    chrono::system_clock::time_point when;
+    double durationMs = 0;
+    uint64_t rowsExamined = 0;
+    string table;           // database/table, empty outside a table
+    uint64_t tableRows = 0;
+    list<string> tokens;    // the statement as tokenized, normalized by the writer
+};
+
+// Bounded ring with one producer and one consumer. head and tail only grow;
+// each side owns one of them, so push and pop never block or lock.
+template <typename T, size_t N>
+class SpscQueue {
+private:
+    T slots[N];
+    atomic<size_t> head{0}; // next slot to pop, written by the consumer
+    atomic<size_t> tail{0}; // next slot to push, written by the producer
+
+public:
+    // Returns false when the ring is full.
+    bool push(T &&item) {
+        size_t t = tail.load(memory_order_relaxed);
+        if (t - head.load(memory_order_acquire) == N)
+            return false;
+        slots[t % N] = std::move(item);
+        tail.store(t + 1, memory_order_release);
+        return true;
+    }
+    bool pop(T &out) {
+        size_t h = head.load(memory_order_relaxed);
+        if (h == tail.load(memory_order_acquire))
+            return false;
+        out = std::move(slots[h % N]);
+        head.store(h + 1, memory_order_release);
+        return true;
+    }
+};
+
+MetricCounter &slowQueriesMetric = metricsRegistry().counter(
+    "qilodb_slow_queries_total", "Statements at or above the slow query threshold.");
+MetricCounter &slowQueriesDroppedMetric = metricsRegistry().counter(
+    "qilodb_slow_queries_dropped_total", "Slow query log entries dropped because the queue was full.");
+
+// Statement text with literal values replaced by '?', so that statements
+// differing only in their values log the same text.
+string normalizeStatement(const list<string> &tokens) {
+    static const char *const operators[] = {"=", "!=", "<", ">", "<=", ">=", LIKE};
+    auto isOperator = [](const string &token) {
+        for (const char *op : operators) {
+            if (token == op)
+                return true;
+        }
+        return false;
+    };
+    vector<string> words;
+    bool literalNext = false;
+    bool insert = !tokens.empty() && tokens.front() == INSERT;
+    for (const string &token : tokens) {
+        if (words.empty()) {
+            words.push_back(token);
+        } else if (insert) {
+            // Rows of an insert collapse into one placeholder.
+            if (words.size() == 1)
+                words.push_back("(?)");
+            else if (words.size() == 2)
+                words.push_back("...");
+        } else if (literalNext || isValidDouble(token)) {
+            words.push_back("?");
+        } else if (token == TO) {
+            // CHANGE <col> <old> TO <new>
+            if (words.size() > 2)
+                words.back() = "?";
+            words.push_back(token);
+        } else if (token.find_first_of(" ,") != string::npos) {
+            words.push_back("(" + token + ")"); // parenthesized by the tokenizer
+        } else if (token[0] == TILDE && isValidDouble(token.substr(1))) {
+            words.push_back("~?");
+        } else {
+            // An operator glued to its operands, e.g. age>=30.
+            size_t op = token.find_first_of("=<>!");
+            size_t value = token.find_last_of("=<>!");
+            if (op != string::npos && op > 0 && value + 1 < token.size())
+                words.push_back(token.substr(0, value + 1) + "?");
+            else
+                words.push_back(token);
+        }
+        literalNext = !insert && words.size() > 1 && (isOperator(token) || token == TO);
+    }
+    string text;
+    for (const string &w : words) {
+        if (!text.empty())
+            text += " ";
+        text += w;
+    }
+    return text;
+}
+
+class SlowQueryLog {
+private:
+    static const size_t QUEUE_SIZE = 256;
+    SpscQueue<SlowQueryEntry, QUEUE_SIZE> queue;
+    thread writer;
+    atomic<bool> stopping{false};
+    mutex wakeLock; // only for the writer's wait, never taken by the producer
+    condition_variable wake;
+    string path;
+
+    void writeEntries() {
+        SlowQueryEntry entry;
+        ofstream out;
+        while (queue.pop(entry)) {
+            if (!out.is_open()) {
+                out.open(path, ios::app);
+                if (!out.is_open())
+                    return; // nowhere to write; the entries are lost
+            }
+            time_t when = chrono::system_clock::to_time_t(entry.when);
+            out << put_time(localtime(&when), "%Y-%m-%dT%H:%M:%S")
+                << fixed << setprecision(3) << " duration_ms=" << entry.durationMs
+                << " rows_examined=" << entry.rowsExamined
+                << " table=" << (entry.table.empty() ? "-" : entry.table)
+                << " table_rows=" << entry.tableRows
+                << " statement=\"" << normalizeStatement(entry.tokens) << "\"\n";
+        }
+    }
+    void run() {
+        while (true) {
+            bool stop = stopping.load(memory_order_acquire);
+            writeEntries();
+            if (stop)
+                return;
+            // The producer notifies without the lock, so a wakeup can be
+            // missed; the timeout bounds how long an entry waits then.
+            unique_lock<mutex> lock(wakeLock);
+            wake.wait_for(lock, chrono::milliseconds(200));
+        }
+    }
+
+public:
+    double thresholdMs = -1; // negative while the log is off
+
+    bool enabled() const { return thresholdMs >= 0; }
+    void enable(double ms) {
+        thresholdMs = ms;
+        if (!writer.joinable()) {
+            path = (fs::path(fs_path) / "slow.log").string();
+            writer = thread(&SlowQueryLog::run, this);
+        }
+    }
+    void disable() { thresholdMs = -1; }
+    const string &logPath() const { return path; }
+    void record(SlowQueryEntry &&entry) {
+        slowQueriesMetric.add();
+        if (!queue.push(std::move(entry))) {
+            slowQueriesDroppedMetric.add();
+            return;
+        }
+        wake.notify_one();
+    }
+    // Writes out what is queued and stops the writer.
+    void stop() {
+        if (!writer.joinable())
+            return;
+        stopping.store(true, memory_order_release);
+        wake.notify_one();
+        writer.join();
+    }
+    ~SlowQueryLog() { stop(); }
+};
+SlowQueryLog slowQueryLog;
+
+// Times one statement dispatched by Parser::parse and queues it for the slow
+// query log if it reached the threshold. Does nothing while the log is off.
+class SlowQueryTimer {
+private:
+    bool active;
+    list<string> statement;
+    uint64_t scannedBefore = 0;
+    ProfileClock::time_point started;
+
+public:
+    explicit SlowQueryTimer(const list<string> &tokens) : active(slowQueryLog.enabled()) {
+        if (!active)
+            return;
+        statement = tokens;
+        scannedBefore = queryProfile.rowsScanned;
+        started = ProfileClock::now();
+    }
+    ~SlowQueryTimer() {
+        if (!active)
+            return;
+        double ms = elapsedMs(started);
+        if (!slowQueryLog.enabled() || ms < slowQueryLog.thresholdMs)
+            return;
+        SlowQueryEntry entry;
+        entry.when = chrono::system_clock::now();
+        entry.durationMs = ms;
+        entry.rowsExamined = queryProfile.rowsScanned - scannedBefore;
+        if (currentTableInstance) {
+            entry.table = currentDatabase + "/" + currentTable;
+            entry.tableRows = currentTableInstance->rowCount();
+        }
+        entry.tokens = std::move(statement);
+        slowQueryLog.record(std::move(entry));
+    }
+    SlowQueryTimer(const SlowQueryTimer &) = delete;
+    SlowQueryTimer &operator=(const SlowQueryTimer &) = delete;
+};
@@ -0,0 +1,122 @@
+#include <cmath>
+#include <thread>
+
+// Sorting for `show ... order by`. Every row gets a sort key (see
+// Table::sortKey) and entries are ordered by (key, scan position), which keeps
+// the sort stable. With a limit only the best entries are kept in a bounded
+// heap; without one they are sorted in memory, on several threads when there
+// are many. Entries point at rows of the loaded table, so a sort needs no
+// more memory than a pointer and a key per row.
+
+static const size_t PARALLEL_SORT_MIN = 1u << 16; // entries per thread worth starting one for
+
+// Calls emit(row). emit may return false to stop the output early, which
+// makes this return false.
+template <typename Emit>
+bool emitRow(Emit &emit, const Row &row) {
+    if constexpr (is_same<decltype(emit(row)), bool>::value) {
+        return emit(row);
+    } else {
+        emit(row);
+        return true;
+    }
+}
+
+// Integer columns also keep the exact value, which orders the keys that
+// rounding to double made equal (BIGINT values above 2^53). Nulls sort after
+// every value in either direction.
+struct SortKey {
+    double value;
+    int64_t exact = 0;
+    bool null = false;
+};
+
+struct SortEntry {
+    SortKey key;
+    uint64_t sequence; // scan position
+    const Row *row;
+};
+
+inline bool sortsBefore(const SortEntry &a, const SortEntry &b) {
+    if (a.key.null != b.key.null)
+        return b.key.null;
+    if (a.key.value != b.key.value)
+        return a.key.value < b.key.value;
+    if (a.key.exact != b.key.exact)
+        return a.key.exact < b.key.exact;
+    return a.sequence < b.sequence;
+}
+
+// Sorts chunks on separate threads, then merges them pairwise.
+void parallelSort(vector<SortEntry> &entries) {
+    size_t threads = min<size_t>(thread::hardware_concurrency(), entries.size() / PARALLEL_SORT_MIN);
+    if (threads < 2) {
+        sort(entries.begin(), entries.end(), sortsBefore);
+        return;
+    }
+    vector<size_t> bounds;
+    for (size_t t = 0; t <= threads; t++)
+        bounds.push_back(entries.size() * t / threads);
+    vector<thread> workers;
+    for (size_t t = 0; t < threads; t++) {
+        workers.emplace_back([&entries, &bounds, t] {
+            sort(entries.begin() + bounds[t], entries.begin() + bounds[t + 1], sortsBefore);
+        });
+    }
+    for (auto &w : workers)
+        w.join();
+    for (size_t width = 1; width < threads; width *= 2) {
+        for (size_t t = 0; t + width < threads; t += 2 * width) {
+            inplace_merge(entries.begin() + bounds[t], entries.begin() + bounds[t + width],
+                          entries.begin() + bounds[min(t + 2 * width, threads)], sortsBefore);
+        }
+    }
+}
+
+// How Table::sortKey turns the cells of the order by column into keys.
+struct SortKeyColumn {
+    int column = -1;
+    bool descending = false;
+    bool numeric = false;
+    bool integer = false;                         // INT and BIGINT, see SortKey::exact
+    int codeSlot = -1;                            // Row::codes slot of dictionary encoded columns
+    vector<double> codeRank;                      // rank of each dictionary code
+    unordered_map<string_view, double> valueRank; // rank of each value of other text columns
+};
+
+class RowSorter {
+private:
+    size_t limit; // 0 when every entry is wanted
+    uint64_t nextSequence = 0;
+    vector<SortEntry> buffer; // a max-heap on sortsBefore while there is a limit
+
+public:
+    explicit RowSorter(size_t limit) : limit(limit) {}
+
+    void add(SortKey key, const Row &row) {
+        SortEntry entry{key, nextSequence++, &row};
+        if (limit == 0) {
+            buffer.push_back(entry);
+        } else if (buffer.size() < limit) {
+            buffer.push_back(entry);
+            push_heap(buffer.begin(), buffer.end(), sortsBefore);
+        } else if (sortsBefore(entry, buffer.front())) {
+            pop_heap(buffer.begin(), buffer.end(), sortsBefore);
+            buffer.back() = entry;
+            push_heap(buffer.begin(), buffer.end(), sortsBefore);
+        }
+    }
+    // Calls emit(row) in order, at most limit times when there is a limit,
+    // until emit returns false (see emitRow).
+    template <typename Emit>
+    void finish(Emit emit) {
+        if (limit > 0)
+            sort_heap(buffer.begin(), buffer.end(), sortsBefore);
+        else
+            parallelSort(buffer);
+        for (const auto &entry : buffer) {
+            if (!emitRow(emit, *entry.row))
+                break;
+        }
+    }
+};
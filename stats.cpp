@@ -0,0 +1,151 @@
+#include <cmath>
+
+// Per-block column statistics ("zone maps").
+// Each block of ROWS_PER_BLOCK rows keeps, for every column, the smallest and
+// largest non-null value, the number of nulls and a small HyperLogLog sketch of
+// the distinct values. A filtered scan skips a block when no OR-group of the
+// condition can be satisfied by the block's value ranges.
+
+static const int HLL_REGISTERS = 64; // 2^6 registers, ~13% standard error
+
+// Stable 64-bit hash (FNV-1a followed by a splitmix64 finalizer); sketches are
+// persisted, so std::hash cannot be used.
+uint64_t stableHash(const string &s) {
+    uint64_t h = 1469598103934665603ULL;
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+// Orders two non-null cells of the same column: numerically for numeric
+// columns, lexicographically otherwise (DATE is YYYY-MM-DD, so this is
+// chronological). Returns <0, 0 or >0.
+int compareCells(const string &a, const string &b, bool numeric) {
+    if (numeric) {
+        double x = strtod(a.c_str(), nullptr);
+        double y = strtod(b.c_str(), nullptr);
+        return (x < y) ? -1 : (x > y ? 1 : 0);
+    }
+    return a.compare(b);
+}
+
+struct ColumnStats {
+    bool hasValues = false;
+    string minValue;
+    string maxValue;
+    uint32_t nullCount = 0;
+    uint8_t hll[HLL_REGISTERS] = {0};
+
+    void add(const string &value, bool numeric) {
+        if (value == "null") {
+            nullCount++;
+            return;
+        }
+        if (!hasValues) {
+            minValue = maxValue = value;
+            hasValues = true;
+        } else if (compareCells(value, minValue, numeric) < 0) {
+            minValue = value;
+        } else if (compareCells(value, maxValue, numeric) > 0) {
+            maxValue = value;
+        }
+        uint64_t h = stableHash(value);
+        int reg = static_cast<int>(h & (HLL_REGISTERS - 1));
+        uint64_t rest = h >> 6;
+        uint8_t rank = 1;
+        while (rank < 58 && !(rest & 1)) {
+            rest >>= 1;
+            rank++;
+        }
+        hll[reg] = max(hll[reg], rank);
+    }
+    void merge(const ColumnStats &other, bool numeric) {
+        if (other.hasValues) {
+            if (!hasValues || compareCells(other.minValue, minValue, numeric) < 0)
+                minValue = other.minValue;
+            if (!hasValues || compareCells(other.maxValue, maxValue, numeric) > 0)
+                maxValue = other.maxValue;
+            hasValues = true;
+        }
+        nullCount += other.nullCount;
+        for (int i = 0; i < HLL_REGISTERS; i++)
+            hll[i] = max(hll[i], other.hll[i]);
+    }
+    // HyperLogLog estimate with the small-range (linear counting) correction.
+    uint64_t distinctEstimate() const {
+        double sum = 0;
+        int zeros = 0;
+        for (int i = 0; i < HLL_REGISTERS; i++) {
+            sum += ldexp(1.0, -hll[i]);
+            if (hll[i] == 0)
+                zeros++;
+        }
+        double m = HLL_REGISTERS;
+        double estimate = 0.709 * m * m / sum;
+        if (estimate <= 2.5 * m && zeros > 0)
+            estimate = m * log(m / zeros);
+        return static_cast<uint64_t>(estimate + 0.5);
+    }
+    // False only when no non-null cell of this block can satisfy "cell op value".
+    bool maySatisfy(const string &op, const string &value, bool numeric) const {
+        if (op == "!=") {
+            // Numeric equality is textual ("5" != "5.0"), so only string columns can be pruned.
+            return numeric || nullCount > 0 || !hasValues || minValue != maxValue || minValue != value;
+        }
+        if (!hasValues)
+            return false;
+        if (op == "=")
+            return compareCells(value, minValue, numeric) >= 0 && compareCells(value, maxValue, numeric) <= 0;
+        if (op == ">")
+            return compareCells(maxValue, value, numeric) > 0;
+        if (op == ">=")
+            return compareCells(maxValue, value, numeric) >= 0;
+        if (op == "<")
+            return compareCells(minValue, value, numeric) < 0;
+        if (op == "<=")
+            return compareCells(minValue, value, numeric) <= 0;
+        return true;
+    }
+    void encode(ByteWriter &out) const {
+        out.putU8(hasValues ? 1 : 0);
+        out.putString(minValue);
+        out.putString(maxValue);
+        out.putU32(nullCount);
+        out.putBytes(reinterpret_cast<const char *>(hll), HLL_REGISTERS);
+    }
+    void decode(ByteReader &in) {
+        hasValues = in.getU8() != 0;
+        minValue = in.getString();
+        maxValue = in.getString();
+        nullCount = in.getU32();
+        for (int i = 0; i < HLL_REGISTERS; i++)
+            hll[i] = in.getU8();
+    }
+};
+
+struct BlockStats {
+    vector<ColumnStats> columns;
+
+    string encode() const {
+        ByteWriter out;
+        out.putU32(static_cast<uint32_t>(columns.size()));
+        for (const auto &c : columns)
+            c.encode(out);
+        return out.buffer;
+    }
+    static BlockStats decode(const string &bytes) {
+        BlockStats stats;
+        ByteReader in(bytes);
+        stats.columns.resize(in.getU32());
+        for (auto &c : stats.columns)
+            c.decode(in);
+        return stats;
+    }
+};
@@ -0,0 +1,643 @@
+#include "serializer.cpp"
+#ifdef QILO_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+// Defined in utils.cpp; both use the session key held in aesKey.
+std::string aesEncrypt(const std::string &plainText, std::string &ivOut);
+std::string aesDecrypt(const std::string &cipherText, const std::string &iv);
+
+//--------------------------------------------------------------------------------
+// Table file container
+//--------------------------------------------------------------------------------
+// A table file is laid out as:
+//   magic (plaintext, 7 bytes) | format version (1 byte)
+//   header section : IV | u32 length | AES(header)
+//   data blocks    : IV | AES(compressed block), one per ROWS_PER_BLOCK rows,
+//                    or one such chunk per column of the block
+//   segments       : u32 length | AES(segment directory) | data blocks,
+//                    zero or more, appended by commits that only add rows
+// The header holds the codec, the schema line and the block directory, so a
+// block, or a single column of it, can be located, decrypted and
+// decompressed on its own. A segment directory lists the blocks that follow
+// it the same way, followed by the keys of stored rows deleted by the
+// commit that wrote it (engine lsm). A segment cut short by a failed write is ignored and
+// overwritten by the next append.
+// Files written before this format are a single IV | AES(payload) envelope.
+//
+// Format versions:
+//   0 - block directory without statistics
+//   1 - every directory entry carries the block's column statistics (stats.cpp)
+//   2 - directory entries list their column chunks; a block without chunks
+//       is stored whole as before
+//   3 - appended segments may follow the blocks of the header
+//   4 - the header records the table engine and segment directories list
+//       the primary keys deleted by the segment's commit
+//   5 - directory entries carry a Bloom filter of the block's primary key
+//       and UNIQUE values (bloom.cpp)
+
+static const string TABLE_FILE_MAGIC = string("QILOTB") + '\x03';
+static const uint8_t TABLE_FILE_VERSION = 5;
+static const size_t TABLE_FILE_PREAMBLE = 8; // magic + version
+static const size_t ROWS_PER_BLOCK = 4096;
+static const size_t MAX_APPENDED_SEGMENTS = 16; // more are merged by a full rewrite
+
+enum CompressionCodec : uint8_t { CODEC_NONE = 0, CODEC_LZ4 = 1, CODEC_DEFLATE = 2 };
+// How a commit stores changes. ENGINE_REWRITE appends inserted rows and
+// rewrites the file for anything else; ENGINE_LSM also records deletes as
+// appended tombstones, so no statement on a single key reads the whole table.
+enum TableEngine : uint8_t { ENGINE_REWRITE = 0, ENGINE_LSM = 1 };
+
+string codecName(CompressionCodec codec) {
+    switch (codec) {
+        case CODEC_NONE: return "none";
+        case CODEC_LZ4: return "lz4";
+        case CODEC_DEFLATE: return "deflate";
+    }
+    return "unknown";
+}
+// Parses a user supplied codec name; only codecs compiled into this build are accepted.
+CompressionCodec parseCodec(const string &name) {
+    string lower = name;
+    transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    if (lower == "none") return CODEC_NONE;
+    if (lower == "lz4") return CODEC_LZ4;
+#ifdef QILO_WITH_ZLIB
+    if (lower == "deflate" || lower == "zlib") return CODEC_DEFLATE;
+#endif
+    throw invalid_argument("Unknown compression codec \"" + name + "\". Available: none, lz4"
+#ifdef QILO_WITH_ZLIB
+                           ", deflate"
+#endif
+                           ".");
+}
+
+string engineName(TableEngine engine) {
+    return engine == ENGINE_LSM ? "lsm" : "rewrite";
+}
+TableEngine parseEngine(const string &name) {
+    string lower = name;
+    transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    if (lower == "lsm") return ENGINE_LSM;
+    if (lower == "rewrite") return ENGINE_REWRITE;
+    throw invalid_argument("Unknown table engine \"" + name + "\". Available: rewrite, lsm.");
+}
+
+// LZ4 block format (https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md),
+// greedy single-probe matcher. The raw size is kept in the block directory.
+string lz4Compress(const string &src) {
+    const size_t n = src.size();
+    const unsigned char *in = reinterpret_cast<const unsigned char *>(src.data());
+    const int HASH_LOG = 12;
+    vector<uint32_t> table(1u << HASH_LOG, 0);
+    string out;
+    out.reserve(n + n / 255 + 16);
+
+    auto read32 = [&](size_t p) {
+        uint32_t v;
+        memcpy(&v, in + p, 4);
+        return v;
+    };
+    auto putLength = [&](size_t len) {
+        while (len >= 255) {
+            out.push_back(static_cast<char>(255));
+            len -= 255;
+        }
+        out.push_back(static_cast<char>(len));
+    };
+
+    size_t anchor = 0, pos = 0;
+    // The last match must start 12 bytes before the end and the last 5 bytes are literals.
+    if (n >= 13) {
+        const size_t matchStartLimit = n - 12;
+        const size_t matchEndLimit = n - 5;
+        while (pos < matchStartLimit) {
+            uint32_t seq = read32(pos);
+            uint32_t h = (seq * 2654435761u) >> (32 - HASH_LOG);
+            size_t candidate = table[h];
+            table[h] = static_cast<uint32_t>(pos);
+            if (candidate >= pos || pos - candidate > 65535 || read32(candidate) != seq) {
+                pos++;
+                continue;
+            }
+            size_t matchLen = 4;
+            while (pos + matchLen < matchEndLimit && in[candidate + matchLen] == in[pos + matchLen])
+                matchLen++;
+
+            size_t litLen = pos - anchor;
+            size_t extra = matchLen - 4;
+            out.push_back(static_cast<char>((min<size_t>(litLen, 15) << 4) | min<size_t>(extra, 15)));
+            if (litLen >= 15)
+                putLength(litLen - 15);
+            out.append(src, anchor, litLen);
+            size_t offset = pos - candidate;
+            out.push_back(static_cast<char>(offset & 0xFF));
+            out.push_back(static_cast<char>(offset >> 8));
+            if (extra >= 15)
+                putLength(extra - 15);
+            pos += matchLen;
+            anchor = pos;
+        }
+    }
+    size_t litLen = n - anchor;
+    out.push_back(static_cast<char>(min<size_t>(litLen, 15) << 4));
+    if (litLen >= 15)
+        putLength(litLen - 15);
+    out.append(src, anchor, litLen);
+    return out;
+}
+
+string lz4Decompress(const string &src, size_t rawLength) {
+    const unsigned char *in = reinterpret_cast<const unsigned char *>(src.data());
+    const size_t n = src.size();
+    string out(rawLength, '\0');
+    size_t ip = 0, op = 0;
+    auto corrupt = []() { return runtime_error("program_error: table block is corrupted (lz4)."); };
+    auto readLength = [&](size_t len) {
+        uint8_t b;
+        do {
+            if (ip >= n) throw corrupt();
+            b = in[ip++];
+            len += b;
+        } while (b == 255);
+        return len;
+    };
+    while (ip < n) {
+        uint8_t token = in[ip++];
+        size_t litLen = token >> 4;
+        if (litLen == 15)
+            litLen = readLength(litLen);
+        if (litLen > n - ip || litLen > rawLength - op) throw corrupt();
+        memcpy(&out[op], in + ip, litLen);
+        ip += litLen;
+        op += litLen;
+        if (ip == n)
+            break; // the last sequence has no match part
+        if (n - ip < 2) throw corrupt();
+        size_t offset = in[ip] | (static_cast<size_t>(in[ip + 1]) << 8);
+        ip += 2;
+        if (offset == 0 || offset > op) throw corrupt();
+        size_t matchLen = token & 15;
+        if (matchLen == 15)
+            matchLen = readLength(matchLen);
+        matchLen += 4;
+        if (matchLen > rawLength - op) throw corrupt();
+        // Byte-wise copy: the match may overlap the bytes being written.
+        for (size_t k = 0; k < matchLen; k++, op++)
+            out[op] = out[op - offset];
+    }
+    if (op != rawLength) throw corrupt();
+    return out;
+}
+
+string compressBlock(const string &raw, CompressionCodec codec) {
+    switch (codec) {
+        case CODEC_NONE:
+            return raw;
+        case CODEC_LZ4:
+            return lz4Compress(raw);
+        case CODEC_DEFLATE: {
+#ifdef QILO_WITH_ZLIB
+            uLongf len = compressBound(raw.size());
+            string out(len, '\0');
+            if (compress2(reinterpret_cast<Bytef *>(&out[0]), &len,
+                          reinterpret_cast<const Bytef *>(raw.data()), raw.size(), Z_DEFAULT_COMPRESSION) != Z_OK)
+                throw runtime_error("program_error: block compression failed.");
+            out.resize(len);
+            return out;
+#else
+            break;
+#endif
+        }
+    }
+    throw runtime_error("program_error: codec " + codecName(codec) + " is not available in this build.");
+}
+
+string decompressBlock(const string &stored, CompressionCodec codec, size_t rawLength) {
+    switch (codec) {
+        case CODEC_NONE:
+            if (stored.size() != rawLength)
+                throw runtime_error("program_error: table block is corrupted.");
+            return stored;
+        case CODEC_LZ4:
+            return lz4Decompress(stored, rawLength);
+        case CODEC_DEFLATE: {
+#ifdef QILO_WITH_ZLIB
+            string out(rawLength, '\0');
+            uLongf len = rawLength;
+            if (uncompress(reinterpret_cast<Bytef *>(&out[0]), &len,
+                           reinterpret_cast<const Bytef *>(stored.data()), stored.size()) != Z_OK || len != rawLength)
+                throw runtime_error("program_error: table block is corrupted (deflate).");
+            return out;
+#else
+            break;
+#endif
+        }
+    }
+    throw runtime_error("program_error: table uses codec " + codecName(codec) + " which is not available in this build.");
+}
+
+// One column of a block stored on its own; offsets as in BlockInfo.
+struct ChunkInfo {
+    uint64_t offset = 0;
+    uint32_t storedLength = 0;
+    uint32_t rawLength = 0;
+};
+
+struct BlockInfo {
+    uint32_t rowCount = 0;
+    uint64_t offset = 0;       // from the first byte after the header section
+    uint32_t storedLength = 0; // IV + ciphertext, of all chunks for a chunked block
+    uint32_t rawLength = 0;    // decompressed payload size, likewise
+    string stats;              // encoded BlockStats, empty when unknown
+    vector<ChunkInfo> chunks;  // one per column, empty when the block is stored whole
+    string filter;             // encoded BloomFilter, empty when unknown
+};
+
+// An appended segment: its blocks start at firstBlock of the directory.
+// A deleted key removes the row with that key from the blocks before it.
+struct SegmentInfo {
+    size_t firstBlock = 0;
+    vector<string> deletedKeys;
+};
+
+struct TableFileHeader {
+    CompressionCodec codec = CODEC_LZ4;
+    TableEngine engine = ENGINE_REWRITE;
+    string schemaLine;
+    uint64_t rowCount = 0; // stored rows, including rows deleted by later segments
+    vector<BlockInfo> blocks;
+    vector<SegmentInfo> segments;
+};
+
+void putBlockInfo(ByteWriter &out, const BlockInfo &b) {
+    out.putU32(b.rowCount);
+    out.putU64(b.offset);
+    out.putU32(b.storedLength);
+    out.putU32(b.rawLength);
+    out.putString(b.stats);
+    out.putU32(static_cast<uint32_t>(b.chunks.size()));
+    for (const auto &c : b.chunks) {
+        out.putU64(c.offset);
+        out.putU32(c.storedLength);
+        out.putU32(c.rawLength);
+    }
+    out.putString(b.filter);
+}
+BlockInfo getBlockInfo(ByteReader &in, uint8_t version) {
+    BlockInfo b;
+    b.rowCount = in.getU32();
+    b.offset = in.getU64();
+    b.storedLength = in.getU32();
+    b.rawLength = in.getU32();
+    if (version >= 1)
+        b.stats = in.getString();
+    if (version >= 2) {
+        b.chunks.resize(in.getU32());
+        for (auto &c : b.chunks) {
+            c.offset = in.getU64();
+            c.storedLength = in.getU32();
+            c.rawLength = in.getU32();
+        }
+    }
+    if (version >= 5)
+        b.filter = in.getString();
+    return b;
+}
+
+// Encrypts a section with a fresh IV: IV | ciphertext.
+string sealSection(const string &plain) {
+    string iv;
+    string cipherText = aesEncrypt(plain, iv);
+    return iv + cipherText;
+}
+string openSection(const string &sealed) {
+    if (sealed.size() < AES_BLOCK_SIZE)
+        throw runtime_error("program_error: table file is truncated.");
+    return aesDecrypt(sealed.substr(AES_BLOCK_SIZE), sealed.substr(0, AES_BLOCK_SIZE));
+}
+
+class TableFileWriter {
+private:
+    TableFileHeader header;
+    string data; // sealed blocks, back to back
+    vector<string> deletedKeys; // appendTo() only
+
+public:
+    TableFileWriter(CompressionCodec codec, const string &schemaLine, TableEngine engine = ENGINE_REWRITE) {
+        header.codec = codec;
+        header.engine = engine;
+        header.schemaLine = schemaLine;
+    }
+    void setDeletedKeys(vector<string> keys) { deletedKeys = std::move(keys); }
+    // A block whose columns are sealed separately, so that readers can
+    // decode only the columns they need.
+    void addColumnBlock(const vector<string> &columns, uint32_t rowCount, const string &stats = "",
+                        const string &filter = "") {
+        BlockInfo info;
+        info.rowCount = rowCount;
+        info.stats = stats;
+        info.filter = filter;
+        info.offset = data.size();
+        for (const string &raw : columns) {
+            ChunkInfo chunk;
+            chunk.offset = data.size();
+            chunk.rawLength = static_cast<uint32_t>(raw.size());
+            string sealed = sealSection(compressBlock(raw, header.codec));
+            chunk.storedLength = static_cast<uint32_t>(sealed.size());
+            data += sealed;
+            info.storedLength += chunk.storedLength;
+            info.rawLength += chunk.rawLength;
+            info.chunks.push_back(chunk);
+        }
+        header.rowCount += rowCount;
+        header.blocks.push_back(info);
+    }
+    void addBlock(const string &raw, uint32_t rowCount, const string &stats = "", const string &filter = "") {
+        BlockInfo info;
+        info.rowCount = rowCount;
+        info.stats = stats;
+        info.filter = filter;
+        info.offset = data.size();
+        info.rawLength = static_cast<uint32_t>(raw.size());
+        string sealed = sealSection(compressBlock(raw, header.codec));
+        info.storedLength = static_cast<uint32_t>(sealed.size());
+        data += sealed;
+        header.rowCount += rowCount;
+        header.blocks.push_back(info);
+    }
+    // Writes a complete table file and returns its length. The file is
+    // written beside the old one and renamed over it (durability.cpp).
+    uint64_t writeTo(const string &filename) {
+        ByteWriter hw;
+        hw.putU8(header.codec);
+        hw.putU8(header.engine);
+        hw.putString(header.schemaLine);
+        hw.putU64(header.rowCount);
+        hw.putU32(static_cast<uint32_t>(header.blocks.size()));
+        for (const auto &b : header.blocks)
+            putBlockInfo(hw, b);
+        string sealedHeader = sealSection(hw.buffer);
+
+        string temp = filename + ".tmp";
+        ofstream out(temp, ios::binary | ios::trunc);
+        if (!out.is_open())
+            throw runtime_error("program_error: could not write table file " + filename + ".");
+        ByteWriter len;
+        len.putU32(static_cast<uint32_t>(sealedHeader.size()));
+        out.write(TABLE_FILE_MAGIC.data(), TABLE_FILE_MAGIC.size());
+        out.put(static_cast<char>(TABLE_FILE_VERSION));
+        out.write(len.buffer.data(), len.buffer.size());
+        out.write(sealedHeader.data(), sealedHeader.size());
+        out.write(data.data(), data.size());
+        out.close();
+        if (!out)
+            throw runtime_error("program_error: could not write table file " + filename + ".");
+        replaceFile(temp, filename);
+        uint64_t written = TABLE_FILE_PREAMBLE + len.buffer.size() + sealedHeader.size() + data.size();
+        bytesWrittenMetric.add(written);
+        return written;
+    }
+    // Writes the blocks as a segment at offset `at` of an existing table
+    // file, the end of its last complete segment, and returns the new end.
+    // The schema and codec must be those of the file.
+    uint64_t appendTo(const string &filename, uint64_t at) {
+        ByteWriter dw;
+        dw.putU64(header.rowCount);
+        dw.putU64(data.size());
+        dw.putU32(static_cast<uint32_t>(header.blocks.size()));
+        for (const auto &b : header.blocks)
+            putBlockInfo(dw, b);
+        dw.putU32(static_cast<uint32_t>(deletedKeys.size()));
+        for (const string &key : deletedKeys)
+            dw.putString(key);
+        string sealedDirectory = sealSection(dw.buffer);
+
+        std::error_code ec;
+        if (fs::file_size(filename, ec) > at && !ec)
+            fs::resize_file(filename, at, ec);
+        fstream out(filename, ios::binary | ios::in | ios::out);
+        if (!out.is_open() || ec)
+            throw runtime_error("program_error: could not write table file " + filename + ".");
+        ByteWriter len;
+        len.putU32(static_cast<uint32_t>(sealedDirectory.size()));
+        out.seekp(at);
+        out.write(len.buffer.data(), len.buffer.size());
+        out.write(sealedDirectory.data(), sealedDirectory.size());
+        out.write(data.data(), data.size());
+        out.close();
+        if (!out)
+            throw runtime_error("program_error: could not write table file " + filename + ".");
+        syncWrittenFile(filename);
+        uint64_t written = len.buffer.size() + sealedDirectory.size() + data.size();
+        bytesWrittenMetric.add(written);
+        return at + written;
+    }
+};
+
+class TableFileReader {
+private:
+    ifstream in;
+    TableFileHeader fileHeader;
+    uint64_t dataStart = 0;
+    uint64_t validEnd = 0; // end of the header blocks and complete segments
+    uint8_t version = 0;
+
+    string readExact(uint64_t offset, size_t len) {
+        string buf(len, '\0');
+        in.seekg(offset);
+        in.read(&buf[0], len);
+        if (static_cast<size_t>(in.gcount()) != len)
+            throw runtime_error("program_error: table file is truncated.");
+        bytesReadMetric.add(len);
+        return buf;
+    }
+
+public:
+    // Returns false when the file is missing or uses the older single-envelope layout.
+    bool open(const string &filename) {
+        in.open(filename, ios::binary);
+        if (!in.is_open())
+            return false;
+        string magic(TABLE_FILE_PREAMBLE, '\0');
+        in.read(&magic[0], magic.size());
+        bytesReadMetric.add(in.gcount());
+        if (static_cast<size_t>(in.gcount()) != magic.size() ||
+            magic.compare(0, TABLE_FILE_MAGIC.size(), TABLE_FILE_MAGIC) != 0) {
+            in.close();
+            return false;
+        }
+        version = static_cast<uint8_t>(magic[TABLE_FILE_MAGIC.size()]);
+        if (version > TABLE_FILE_VERSION)
+            throw runtime_error("program_error: table file was written by a newer version of qiloDB.");
+        string lenBytes = readExact(TABLE_FILE_PREAMBLE, 4);
+        uint32_t headerLength = ByteReader(lenBytes).getU32();
+        string plain = openSection(readExact(TABLE_FILE_PREAMBLE + 4, headerLength));
+        dataStart = TABLE_FILE_PREAMBLE + 4 + headerLength;
+
+        ByteReader hr(plain);
+        fileHeader.codec = static_cast<CompressionCodec>(hr.getU8());
+        if (version >= 4)
+            fileHeader.engine = static_cast<TableEngine>(hr.getU8());
+        fileHeader.schemaLine = hr.getString();
+        fileHeader.rowCount = hr.getU64();
+        uint32_t blockCount = hr.getU32();
+        uint64_t dataLength = 0;
+        for (uint32_t i = 0; i < blockCount; i++) {
+            fileHeader.blocks.push_back(getBlockInfo(hr, version));
+            dataLength = max<uint64_t>(dataLength, fileHeader.blocks.back().offset + fileHeader.blocks.back().storedLength);
+        }
+        validEnd = dataStart + dataLength;
+        if (version >= 3)
+            readSegments();
+        return true;
+    }
+    // Adds the blocks of the appended segments to the directory, with
+    // offsets from dataStart like the header's own blocks. A segment that
+    // does not fit in the file, or whose directory does not decrypt or parse,
+    // was cut short by a failed write: it and whatever follows are left out,
+    // and validEnd stays before it so the next append overwrites it.
+    void readSegments() {
+        in.seekg(0, ios::end);
+        uint64_t fileSize = static_cast<uint64_t>(in.tellg());
+        while (validEnd + 4 <= fileSize) {
+            uint32_t length = ByteReader(readExact(validEnd, 4)).getU32();
+            uint64_t blocksStart = validEnd + 4 + length;
+            if (blocksStart > fileSize)
+                break;
+            uint64_t rowCount, dataLength;
+            vector<BlockInfo> blocks;
+            SegmentInfo segment;
+            try {
+                string plain = openSection(readExact(validEnd + 4, length));
+                ByteReader sr(plain);
+                rowCount = sr.getU64();
+                dataLength = sr.getU64();
+                uint32_t blockCount = sr.getU32();
+                for (uint32_t i = 0; i < blockCount; i++)
+                    blocks.push_back(getBlockInfo(sr, version));
+                if (version >= 4) {
+                    segment.deletedKeys.resize(sr.getU32());
+                    for (auto &key : segment.deletedKeys)
+                        key = sr.getString();
+                }
+            } catch (const exception &) {
+                in.clear();
+                break;
+            }
+            if (blocksStart + dataLength > fileSize)
+                break;
+            segment.firstBlock = fileHeader.blocks.size();
+            for (BlockInfo &b : blocks) {
+                b.offset += blocksStart - dataStart;
+                for (auto &c : b.chunks)
+                    c.offset += blocksStart - dataStart;
+                fileHeader.blocks.push_back(std::move(b));
+            }
+            fileHeader.rowCount += rowCount;
+            fileHeader.segments.push_back(std::move(segment));
+            validEnd = blocksStart + dataLength;
+        }
+    }
+    const TableFileHeader &header() const { return fileHeader; }
+    uint8_t formatVersion() const { return version; }
+    // Where the next segment is appended.
+    uint64_t appendOffset() const { return validEnd; }
+    size_t segmentCount() const { return fileHeader.segments.size(); }
+    size_t blockCount() const { return fileHeader.blocks.size(); }
+    // Whether every block is stored as column chunks.
+    bool columnar() const {
+        for (const auto &b : fileHeader.blocks) {
+            if (b.chunks.empty())
+                return false;
+        }
+        return true;
+    }
+    // Reads, decrypts and decompresses a single block stored whole.
+    string readBlock(size_t index) {
+        const BlockInfo &b = fileHeader.blocks[index];
+        string plain = openSection(readExact(dataStart + b.offset, b.storedLength));
+        return decompressBlock(plain, fileHeader.codec, b.rawLength);
+    }
+    // Reads, decrypts and decompresses one column chunk of a block.
+    string readChunk(size_t index, size_t column) {
+        const BlockInfo &b = fileHeader.blocks[index];
+        if (column >= b.chunks.size())
+            throw runtime_error("program_error: table data is corrupted (missing column chunk).");
+        const ChunkInfo &c = b.chunks[column];
+        string plain = openSection(readExact(dataStart + c.offset, c.storedLength));
+        return decompressBlock(plain, fileHeader.codec, c.rawLength);
+    }
+    void close() { in.close(); }
+};
+
+// Re-encrypts one table file from oldKey to newKey, keeping its layout.
+void rotateTableFileKey(const fs::path &path, const string &oldKey, const string &newKey) {
+    std::string savedKey = aesKey;
+    try {
+        TableFileReader reader;
+        aesKey = oldKey;
+        if (reader.open(path.string())) {
+            // Every block (or column chunk) is decrypted and sealed again under the new key.
+            TableFileHeader header = reader.header();
+            vector<vector<string>> rawBlocks(reader.blockCount());
+            for (size_t i = 0; i < reader.blockCount(); i++) {
+                if (header.blocks[i].chunks.empty()) {
+                    rawBlocks[i].push_back(reader.readBlock(i));
+                    continue;
+                }
+                for (size_t c = 0; c < header.blocks[i].chunks.size(); c++)
+                    rawBlocks[i].push_back(reader.readChunk(i, c));
+            }
+            reader.close();
+            aesKey = newKey;
+            // The header's blocks first, then every segment with its deleted keys.
+            auto addBlocks = [&](TableFileWriter &writer, size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    if (header.blocks[i].chunks.empty())
+                        writer.addBlock(rawBlocks[i][0], header.blocks[i].rowCount, header.blocks[i].stats,
+                                        header.blocks[i].filter);
+                    else
+                        writer.addColumnBlock(rawBlocks[i], header.blocks[i].rowCount, header.blocks[i].stats,
+                                              header.blocks[i].filter);
+                }
+            };
+            auto segmentEnd = [&](size_t s) {
+                return s + 1 < header.segments.size() ? header.segments[s + 1].firstBlock : header.blocks.size();
+            };
+            // The new file is put together beside the old one and replaces it whole.
+            string rotated = path.string() + ".rotate";
+            TableFileWriter writer(header.codec, header.schemaLine, header.engine);
+            addBlocks(writer, 0, header.segments.empty() ? header.blocks.size() : header.segments[0].firstBlock);
+            uint64_t end = writer.writeTo(rotated);
+            for (size_t s = 0; s < header.segments.size(); s++) {
+                TableFileWriter segment(header.codec, header.schemaLine, header.engine);
+                addBlocks(segment, header.segments[s].firstBlock, segmentEnd(s));
+                segment.setDeletedKeys(header.segments[s].deletedKeys);
+                end = segment.appendTo(rotated, end);
+            }
+            replaceFile(rotated, path.string());
+        } else {
+            // Older layout: IV + ciphertext of the whole payload.
+            std::ifstream in(path, std::ios::binary);
+            std::string iv(AES_BLOCK_SIZE, '\0');
+            in.read(&iv[0], AES_BLOCK_SIZE);
+            std::string cipherText{ std::istreambuf_iterator<char>(in),
+                                     std::istreambuf_iterator<char>() };
+            in.close();
+            bytesReadMetric.add(iv.size() + cipherText.size());
+
+            std::string plain = aesDecrypt(cipherText, iv);
+            aesKey = newKey;
+            std::string newIv;
+            std::string newCipher = aesEncrypt(plain, newIv);
+
+            writeFileAtomically(path.string(), newIv + newCipher);
+            bytesWrittenMetric.add(newIv.size() + newCipher.size());
+        }
+    } catch (...) {
+        aesKey = savedKey;
+        throw;
+    }
+    aesKey = savedKey;
+}
@@ -1,11 +1,30 @@
 #include "row.cpp"
 #include "library.cpp"  // Or your other necessary headers
+#include "dictionary.cpp"
+#include "stats.cpp"
+#include "bloom.cpp"
+#include "schema.cpp"
+#include "sort.cpp"
+#include "aggregate.cpp"
+#include "join.cpp"
+#include "primary_index.cpp"
+#include "like.cpp"
+#include "fulltext.cpp"
+#include "pager.cpp"
 
 struct Condition {
     string column;
     string op;     // Operator (e.g., =, >, <, <=, >=, / for not equal)
     string value;
+    // Resolved once by parseAdvancedConditions so rows are not looked up by name.
+    int colIndex = -1;
+    uint32_t code = StringDictionary::NOT_FOUND; // dictionary code of value (encoded columns)
+    shared_ptr<const vector<char>> textHits;     // MATCHES: whether each dictionary code matches
+    shared_ptr<const vector<uint32_t>> textCodes; // MATCHES: the matching codes, ascending
 };
+// Marks the binary table payload; legacy payloads start with the CSV header.
+static const string TABLE_PAYLOAD_MAGIC = string("QILO") + '\x02';
+enum ColumnEncoding : uint8_t { ENCODING_PLAIN = 0, ENCODING_DICTIONARY = 1 };
 extern string currentTable;
 extern string fs_path;
 extern string currentDatabase;
@@ -40,116 +59,58 @@ vector<string> extractValues(const string &command)
     }
     return values;
 }
-bool validateValue(const string &value, const string &dataType) {
-    if(value == "null"){
-        return true;
-    }
-    if (dataType == "INT") {
-        try {
-            size_t idx;
-            stoi(value, &idx);
-            if (idx != value.size())
-                return false;
-        } catch (...) {
-            return false;
-        }
-        return true;
-    }
-    else if (dataType == "BIGINT") {
-        try {
-            size_t idx;
-            stoll(value, &idx);
-            if (idx != value.size())
-                return false;
-        } catch (...) {
-            return false;
-        }
-        return true;
-    }
-    else if (dataType == "DOUBLE") {
-        try {
-            size_t idx;
-            stod(value, &idx);
-            if (idx != value.size())
-                return false;
-        } catch (...) {
-            return false;
-        }
-        return true;
-    }
-    else if (dataType == "BIGDOUBLE") {
-        try {
-            size_t idx;
-            stold(value, &idx);
-            if (idx != value.size())
-                return false;
-        } catch (...) {
-            return false;
-        }
-        return true;
-    }
-    else if (dataType == "CHAR") {
-        // For CHAR, ensure the string length is exactly one.
-        return value.size() == 1;
-    }
-    else if (dataType == "VARCHAR" || dataType == "STRING") {
-        return !value.empty();
-    }
-    else if (dataType == "DATE") {
-        // Validate date in format YYYY-MM-DD using regex.
-        regex dateRegex("^\\d{4}-\\d{2}-\\d{2}$");
-        if (!regex_match(value, dateRegex))
-            return false;
-        // Further validate the date components.
-        int year, month, day;
-        try {
-            year = stoi(value.substr(0, 4));
-            month = stoi(value.substr(5, 2));
-            day = stoi(value.substr(8, 2));
-        } catch (...) {
-            return false;
+// Splits show() parameters on whitespace; quoted text stays in one token,
+// quotes included, so a pattern or search with spaces is not broken up.
+vector<string> splitShowParams(const string &params) {
+    vector<string> tokens;
+    string token;
+    char quote = 0;
+    for (char c : params) {
+        if (quote) {
+            token.push_back(c);
+            if (c == quote)
+                quote = 0;
+        } else if (c == ' ' || c == '\t') {
+            if (!token.empty())
+                tokens.push_back(token);
+            token.clear();
+        } else {
+            if (c == '"' || c == '\'')
+                quote = c;
+            token.push_back(c);
         }
-        if (month < 1 || month > 12)
-            return false;
-        // Check days in month (basic check, does not fully account for leap years)
-        int daysInMonth[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
-        if (day < 1 || day > daysInMonth[month - 1])
-            return false;
-        return true;
-    }
-    else if (dataType == "BOOL") {
-        string lowerValue = value;
-        transform(lowerValue.begin(), lowerValue.end(), lowerValue.begin(), ::tolower);
-        return (lowerValue == "true" || lowerValue == "false" || lowerValue == "1" || lowerValue == "0");
     }
-    // Additional data types can be added here.
-    return false;
+    if (!token.empty())
+        tokens.push_back(token);
+    return tokens;
 }
-bool compareValues(const string &actual, const string &op, const string &expected) {
-    // Try to treat both values as numbers.
-    double a, b;
-    bool isNumeric = false;
-    try {
-        a = stod(actual);
-        b = stod(expected);
-        isNumeric = true;
-    } catch (...) {
-        // Not numeric; fall back to string comparison.
-    }
+// Compares a cell against a condition value. Ordering follows the column type
+// (see compareCells) so that it agrees with the block zone maps.
+bool compareValues(const string &actual, const string &op, const string &expected, bool numeric) {
     if (op == "=")
         return actual == expected;
-    else if (op == ">" )
-        return isNumeric ? (a > b) : (actual > expected);
+    else if (op == "!=")
+        return actual != expected;
+    // Nulls never satisfy an ordering comparison.
+    if (actual == "null")
+        return false;
+    int cmp = compareCells(actual, expected, numeric);
+    if (op == ">" )
+        return cmp > 0;
     else if (op == "<")
-        return isNumeric ? (a < b) : (actual < expected);
+        return cmp < 0;
     else if (op == ">=")
-        return isNumeric ? (a >= b) : (actual >= expected);
+        return cmp >= 0;
     else if (op == "<=")
-        return isNumeric ? (a <= b) : (actual <= expected);
-    else if (op == "!=")
-        return actual != expected;
+        return cmp <= 0;
     return false;
 }
+// Zone map of a contiguous range of rowOrder.
+struct ZoneMap {
+    size_t begin;
+    size_t end;
+    BlockStats stats;
+};
 // class declaration
 class Table {
 private:
@@ -159,10 +120,554 @@ private:
     vector<string> headers;
     unordered_map<string, Row> dataMap;
     vector<string> rowOrder;  // Keeps row IDs in CSV insertion order.
-    unordered_map<string, pair<string, string>> columnMeta;
+    vector<ColumnSchema> schema; // parallel to headers
     int primaryKeyIndex; 
     int columnWidth;
     bool unsavedChanges;
+    int valueSlotCount = 0;
+    vector<StringDictionary> dictionaries; // one per Row::codes slot
+    vector<unique_ptr<TrigramIndex>> trigramIndexes; // per slot, built by likeMatches when needed
+    vector<unique_ptr<FulltextIndex>> fulltextIndexes; // per slot, for COLUMN_FULLTEXT columns
+    // Rows holding each dictionary code of a full-text indexed column, in
+    // rowOrder, so MATCHES visits only the matching rows. A slot's lists are
+    // built by the first MATCHES scan that needs them and extended by
+    // inserts; anything else that changes rows clears them.
+    vector<vector<vector<Row *>>> fulltextRows; // per slot, per code
+    CompressionCodec codec = CODEC_LZ4;    // block codec used on commit
+    // Zone maps covering rowOrder in order. Inserts extend the last zone;
+    // deletes and updates invalidate them and they are rebuilt by the next
+    // filtered scan.
+    vector<ZoneMap> zoneMaps;
+    bool zoneMapsValid = false;
+    MetricGauge *rowsInMemory = nullptr; // qilodb_table_rows of this table
+    // Integer primary keys are also kept in primaryIndex, which serves key
+    // lookups and key range conditions. primaryIndexed is false for other key
+    // types.
+    PrimaryIndex primaryIndex;
+    bool primaryIndexed = false;
+    uint64_t nextSequence = 0; // Row::sequence of the next inserted row
+    // Columns not decoded yet, while columnSource is open. storedSlots holds
+    // the row of every stored position of its blocks, nullptr for rows
+    // deleted since, so a column decoded late lands in the right rows.
+    unique_ptr<TableFileReader> columnSource;
+    vector<char> columnLoaded;
+    vector<Row *> storedSlots;
+    // A table stored in column chunks opens from the file header alone; its
+    // rows are read by ensureRows() on the first lookup or scan. Until then
+    // rowOrder holds only rows inserted since (engine lsm).
+    bool rowsPending = false;
+    size_t storedRows = 0; // live rows in the file, known before they are read
+    TableEngine engine = ENGINE_REWRITE;
+    // Engine lsm: keys of committed rows deleted since the last commit, saved
+    // with the next segment. While the rows are on disk, a stored row of
+    // block b is deleted when b < deadBefore[key]; probedKeys caches the keys
+    // of the blocks storedKey() has read.
+    vector<string> deletedKeys;
+    unordered_map<string, size_t> deadBefore;
+    unordered_map<size_t, vector<string>> probedKeys;
+    // While appendable, the first committedRows rows of rowOrder are the
+    // rows of the file and the rest were inserted since, so a commit only
+    // appends those as a new segment. Statements that change stored rows,
+    // or remove them outside engine lsm, clear it and the next commit
+    // rewrites the file.
+    bool appendable = false;
+    size_t committedRows = 0;
+    string committedSchema;       // header line and codec of the file
+    CompressionCodec committedCodec = CODEC_LZ4;
+    uint64_t appendOffset = 0;    // see TableFileReader::appendOffset
+    size_t appendedSegments = 0;
+
+    void publishRowCount() {
+        if (rowsInMemory)
+            rowsInMemory->set(static_cast<int64_t>(rowOrder.size()));
+    }
+
+    // Assigns row slots to the columns. String columns are always dictionary
+    // encoded; the primary key has no slot, it is stored in Row::id.
+    void buildCellLayout() {
+        int codeSlots = 0;
+        valueSlotCount = 0;
+        for (size_t i = 0; i < schema.size(); i++) {
+            ColumnSchema &column = schema[i];
+            column.dictEncoded = false;
+            column.slot = -1;
+            if ((int)i == primaryKeyIndex)
+                continue;
+            if (isStringType(column.type)) {
+                column.dictEncoded = true;
+                column.slot = codeSlots++;
+            } else {
+                column.slot = valueSlotCount++;
+            }
+        }
+        dictionaries.resize(codeSlots);
+        trigramIndexes.clear();
+        fulltextIndexes.clear();
+        fulltextRows.clear();
+    }
+    // Whether each value of a dictionary column matches pattern. Large
+    // dictionaries are narrowed down to the values holding the pattern's
+    // trigrams first.
+    vector<char> likeMatches(int slot, const LikePattern &pattern) {
+        const StringDictionary &dict = dictionaries[slot];
+        vector<char> hits(dict.size(), 0);
+        vector<uint32_t> trigrams = pattern.requiredTrigrams();
+        if (dict.size() >= QILO_TRIGRAM_MIN_ENTRIES && !trigrams.empty()) {
+            if (trigramIndexes.size() < dictionaries.size())
+                trigramIndexes.resize(dictionaries.size());
+            if (!trigramIndexes[slot])
+                trigramIndexes[slot].reset(new TrigramIndex());
+            trigramIndexes[slot]->update(dict);
+            for (uint32_t code : trigramIndexes[slot]->candidates(trigrams))
+                hits[code] = pattern.matches(dict.valueOf(code));
+            return hits;
+        }
+        for (uint32_t code = 0; code < dict.size(); code++)
+            hits[code] = pattern.matches(dict.valueOf(code));
+        return hits;
+    }
+    // Brings the full-text indexes up to date with the dictionaries of their
+    // columns; only values added since the last call are indexed. Called by
+    // the statements that use the indexes, not when rows change.
+    void refreshFulltextIndexes() {
+        for (const auto &column : schema) {
+            if (!column.has(COLUMN_FULLTEXT) || !column.dictEncoded)
+                continue;
+            if (fulltextIndexes.size() < dictionaries.size())
+                fulltextIndexes.resize(dictionaries.size());
+            if (!fulltextIndexes[column.slot])
+                fulltextIndexes[column.slot].reset(new FulltextIndex());
+            fulltextIndexes[column.slot]->update(dictionaries[column.slot]);
+        }
+    }
+    // Resolves a MATCHES condition to the dictionary codes of its column
+    // holding every word of its value.
+    void resolveFulltextMatch(Condition &cond) {
+        vector<string> terms;
+        fulltextTerms(cond.value, terms);
+        if (terms.empty())
+            throw ("syntax_error: MATCHES -> no words to search for in \"" + cond.value + "\".");
+        refreshFulltextIndexes();
+        int slot = schema[cond.colIndex].slot;
+        auto codes = make_shared<vector<uint32_t>>(fulltextIndexes[slot]->matching(terms));
+        auto hits = make_shared<vector<char>>(dictionaries[slot].size(), 0);
+        for (uint32_t code : *codes)
+            (*hits)[code] = 1;
+        cond.textCodes = codes;
+        cond.textHits = hits;
+    }
+    // The rows of each code of a full-text indexed column; see fulltextRows.
+    const vector<vector<Row *>> &rowsByCode(int slot) {
+        if (fulltextRows.size() < dictionaries.size())
+            fulltextRows.resize(dictionaries.size());
+        vector<vector<Row *>> &byCode = fulltextRows[slot];
+        if (byCode.empty()) {
+            byCode.resize(dictionaries[slot].size());
+            for (const auto &id : rowOrder) {
+                auto it = dataMap.find(id);
+                if (it != dataMap.end())
+                    byCode[it->second.codes[slot]].push_back(&it->second);
+            }
+        }
+        return byCode;
+    }
+    // Adds an inserted row to the row lists already built.
+    void extendFulltextRows(Row &row) {
+        for (size_t slot = 0; slot < fulltextRows.size(); slot++) {
+            vector<vector<Row *>> &byCode = fulltextRows[slot];
+            if (byCode.empty())
+                continue;
+            if (byCode.size() < dictionaries[slot].size())
+                byCode.resize(dictionaries[slot].size());
+            byCode[row.codes[slot]].push_back(&row);
+        }
+    }
+    // Rows holding a value a MATCHES condition matched, in rowOrder, when
+    // every group has such a condition and they hold few enough rows to beat
+    // a scan. Returns false otherwise.
+    bool fulltextCandidates(const vector<vector<Condition>> &groups, vector<Row *> &rows) {
+        vector<const Condition *> matches;
+        for (const auto &group : groups) {
+            auto it = find_if(group.begin(), group.end(), [](const Condition &cond) { return cond.textCodes != nullptr; });
+            if (it == group.end())
+                return false;
+            matches.push_back(&*it);
+        }
+        size_t estimate = 0;
+        for (const Condition *cond : matches) {
+            const vector<vector<Row *>> &byCode = rowsByCode(schema[cond->colIndex].slot);
+            for (uint32_t code : *cond->textCodes)
+                estimate += code < byCode.size() ? byCode[code].size() : 0;
+        }
+        if (estimate > rowOrder.size() / 4)
+            return false;
+        for (const Condition *cond : matches) {
+            const vector<vector<Row *>> &byCode = rowsByCode(schema[cond->colIndex].slot);
+            for (uint32_t code : *cond->textCodes) {
+                if (code < byCode.size())
+                    rows.insert(rows.end(), byCode[code].begin(), byCode[code].end());
+            }
+        }
+        sort(rows.begin(), rows.end(), [](const Row *a, const Row *b) { return a->sequence < b->sequence; });
+        rows.erase(unique(rows.begin(), rows.end()), rows.end());
+        return true;
+    }
+    // Indexes every row and numbers Row::sequence in rowOrder; after a load.
+    void rebuildPrimaryIndex() {
+        primaryIndex.clear();
+        primaryIndexed = primaryKeyIndex >= 0 && primaryKeyIndex < (int)schema.size() &&
+                         (schema[primaryKeyIndex].type == TYPE_INT || schema[primaryKeyIndex].type == TYPE_BIGINT);
+        vector<PrimaryIndex::Entry> entries;
+        entries.reserve(primaryIndexed ? rowOrder.size() : 0);
+        nextSequence = 0;
+        for (const auto &id : rowOrder) {
+            auto it = dataMap.find(id);
+            if (it == dataMap.end())
+                continue;
+            it->second.sequence = nextSequence++;
+            int64_t key;
+            if (primaryIndexed && parseInteger(id, key))
+                entries.push_back({key, &it->second});
+            else
+                primaryIndexed = false;
+        }
+        if (primaryIndexed)
+            primaryIndex.build(std::move(entries));
+    }
+    void indexRow(Row &row) {
+        row.sequence = nextSequence++;
+        int64_t key;
+        if (!primaryIndexed)
+            return;
+        if (parseInteger(row.id, key)) {
+            primaryIndex.insert(key, &row);
+        } else {
+            primaryIndexed = false;
+            primaryIndex.clear();
+        }
+    }
+    void unindexRow(const Row &row) {
+        int64_t key;
+        if (primaryIndexed && parseInteger(row.id, key))
+            primaryIndex.erase(key, &row);
+    }
+    // Row with the given primary key, or nullptr. Integer keys are looked up
+    // by value, so 7 also finds a row stored as +7.
+    Row *findRow(const string &id) {
+        ensureRows();
+        return findLoadedRow(id);
+    }
+    Row *findLoadedRow(const string &id) {
+        int64_t key;
+        if (primaryIndexed && parseInteger(id, key))
+            return primaryIndex.find(key);
+        auto it = dataMap.find(id);
+        return it == dataMap.end() ? nullptr : &it->second;
+    }
+    // Rows whose key can satisfy the condition groups, in rowOrder, when every
+    // group bounds the primary key and the ranges hold few enough rows to beat
+    // a scan. Returns false otherwise.
+    bool primaryKeyCandidates(const vector<vector<Condition>> &groups, vector<Row *> &rows) {
+        if (!primaryIndexed)
+            return false;
+        vector<pair<int64_t, int64_t>> ranges;
+        size_t estimate = 0;
+        for (const auto &group : groups) {
+            int64_t low = INT64_MIN, high = INT64_MAX;
+            bool bounded = false, empty = false;
+            for (const auto &cond : group) {
+                int64_t v;
+                if (cond.colIndex != primaryKeyIndex || !parseInteger(cond.value, v))
+                    continue;
+                if (cond.op == "=") {
+                    low = max(low, v);
+                    high = min(high, v);
+                } else if (cond.op == ">") {
+                    empty = empty || v == INT64_MAX;
+                    low = max(low, v == INT64_MAX ? v : v + 1);
+                } else if (cond.op == ">=") {
+                    low = max(low, v);
+                } else if (cond.op == "<") {
+                    empty = empty || v == INT64_MIN;
+                    high = min(high, v == INT64_MIN ? v : v - 1);
+                } else if (cond.op == "<=") {
+                    high = min(high, v);
+                } else {
+                    continue;
+                }
+                bounded = true;
+            }
+            if (!bounded)
+                return false;
+            if (empty || low > high)
+                continue;
+            ranges.push_back({low, high});
+            estimate += primaryIndex.countInRange(low, high);
+        }
+        if (estimate > rowOrder.size() / 4)
+            return false;
+        for (const auto &range : ranges)
+            primaryIndex.forEachInRange(range.first, range.second, [&](Row *row) { rows.push_back(row); });
+        sort(rows.begin(), rows.end(), [](const Row *a, const Row *b) { return a->sequence < b->sequence; });
+        rows.erase(unique(rows.begin(), rows.end()), rows.end());
+        return true;
+    }
+    const string &cellAt(const Row &row, int colIndex) const {
+        static const string empty;
+        if (colIndex == primaryKeyIndex)
+            return row.id;
+        int slot = schema[colIndex].slot;
+        if (schema[colIndex].dictEncoded)
+            return (slot < (int)row.codes.size()) ? dictionaries[slot].valueOf(row.codes[slot]) : empty;
+        return (slot < (int)row.values.size()) ? row.values[slot] : empty;
+    }
+    void setCell(Row &row, int colIndex, const string &value) {
+        if (colIndex == primaryKeyIndex) {
+            row.id = value;
+            return;
+        }
+        int slot = schema[colIndex].slot;
+        if (schema[colIndex].dictEncoded)
+            row.codes[slot] = dictionaries[slot].intern(value);
+        else
+            row.values[slot] = value;
+    }
+    // Builds a Row from one cell per header (primary key included).
+    Row makeRow(const vector<string> &cells) {
+        Row row;
+        row.values.resize(valueSlotCount);
+        row.codes.resize(dictionaries.size());
+        for (size_t i = 0; i < headers.size(); i++)
+            setCell(row, i, cells[i]);
+        return row;
+    }
+    BlockStats computeBlockStats(const vector<const Row *> &rows, size_t begin, size_t end) const {
+        BlockStats stats;
+        stats.columns.resize(headers.size());
+        for (size_t r = begin; r < end; r++) {
+            for (size_t i = 0; i < headers.size(); i++)
+                stats.columns[i].add(cellAt(*rows[r], i), schema[i].numeric);
+        }
+        return stats;
+    }
+    void ensureZoneMaps() {
+        if (zoneMapsValid)
+            return;
+        ensureAllColumns();
+        vector<const Row *> rows = orderedRows();
+        zoneMaps.clear();
+        for (size_t begin = 0; begin < rows.size(); begin += ROWS_PER_BLOCK) {
+            size_t end = min(rows.size(), begin + ROWS_PER_BLOCK);
+            zoneMaps.push_back({begin, end, computeBlockStats(rows, begin, end)});
+        }
+        zoneMapsValid = true;
+    }
+    // Keeps the zone maps current after a row is appended to rowOrder.
+    void extendZoneMaps(const Row &row) {
+        if (!zoneMapsValid || rowsPending) // ensureRows() covers rows inserted before it
+            return;
+        size_t position = rowOrder.size() - 1;
+        if (zoneMaps.empty() || zoneMaps.back().end - zoneMaps.back().begin >= ROWS_PER_BLOCK) {
+            zoneMaps.push_back({position, position, BlockStats()});
+            zoneMaps.back().stats.columns.resize(headers.size());
+        }
+        ZoneMap &zone = zoneMaps.back();
+        for (size_t i = 0; i < headers.size(); i++)
+            zone.stats.columns[i].add(cellAt(row, i), schema[i].numeric);
+        zone.end = position + 1;
+    }
+    // Calls visit(row) for the rows of every zone that may satisfy the
+    // condition groups, in rowOrder. All rows are visited when groups is empty.
+    // visit must not add or remove rows; it may return false to end the scan.
+    template <typename Visit>
+    void forEachCandidateRow(const vector<vector<Condition>> &groups, Visit visit) {
+        ensureRows();
+        PhaseTimer scanning(PHASE_SCAN);
+        bool ended = false;
+        auto proceed = [&](Row &row) {
+            queryProfile.rowsScanned++;
+            if constexpr (is_same<decltype(visit(row)), bool>::value)
+                ended = !visit(row);
+            else
+                visit(row);
+            return !ended;
+        };
+        auto visitRange = [&](size_t begin, size_t end) {
+            uint64_t visited = 0;
+            for (size_t p = begin; p < end && !ended; p++) {
+                auto it = dataMap.find(rowOrder[p]);
+                if (it != dataMap.end()) {
+                    visited++;
+                    proceed(it->second);
+                }
+            }
+            rowsScannedMetric.add(visited);
+        };
+        if (groups.empty()) {
+            visitRange(0, rowOrder.size());
+            return;
+        }
+        vector<Row *> keyed;
+        if (primaryKeyCandidates(groups, keyed) || fulltextCandidates(groups, keyed)) {
+            uint64_t visited = 0;
+            for (Row *row : keyed) {
+                visited++;
+                if (!proceed(*row))
+                    break;
+            }
+            rowsScannedMetric.add(visited);
+            return;
+        }
+        ensureZoneMaps();
+        uint64_t scanned = 0, skipped = 0;
+        for (const auto &zone : zoneMaps) {
+            if (ended)
+                break;
+            if (zoneMaySatisfy(zone, groups)) {
+                visitRange(zone.begin, zone.end);
+                scanned++;
+            } else {
+                skipped++;
+            }
+        }
+        zoneBlocksScannedMetric.add(scanned);
+        zoneBlocksSkippedMetric.add(skipped);
+    }
+    // Numeric columns sort by value; text columns by the rank of the value
+    // among the column's sorted distinct values, so every key is a double;
+    // integer columns add their exact value (SortKey). Nulls are ranked
+    // HUGE_VAL here and sortKey marks them, so they come last with asc and desc.
+    SortKeyColumn sortKeyColumn(int col, bool descending) const {
+        SortKeyColumn key;
+        key.column = col;
+        key.descending = descending;
+        key.numeric = schema[col].numeric;
+        key.integer = schema[col].type == TYPE_INT || schema[col].type == TYPE_BIGINT;
+        if (key.numeric)
+            return key;
+        if (col != primaryKeyIndex && schema[col].dictEncoded) {
+            key.codeSlot = schema[col].slot;
+            const StringDictionary &dict = dictionaries[key.codeSlot];
+            vector<uint32_t> codes(dict.size());
+            for (uint32_t c = 0; c < codes.size(); c++)
+                codes[c] = c;
+            sort(codes.begin(), codes.end(),
+                 [&](uint32_t a, uint32_t b) { return dict.valueOf(a) < dict.valueOf(b); });
+            key.codeRank.resize(dict.size());
+            for (size_t r = 0; r < codes.size(); r++)
+                key.codeRank[codes[r]] = dict.valueOf(codes[r]) == "null" ? HUGE_VAL : static_cast<double>(r);
+            return key;
+        }
+        vector<string_view> distinct;
+        for (const auto &entry : dataMap) {
+            const string &value = cellAt(entry.second, col);
+            if (key.valueRank.emplace(value, 0.0).second)
+                distinct.push_back(value);
+        }
+        sort(distinct.begin(), distinct.end());
+        for (size_t r = 0; r < distinct.size(); r++)
+            key.valueRank[distinct[r]] = distinct[r] == "null" ? HUGE_VAL : static_cast<double>(r);
+        return key;
+    }
+    SortKey sortKey(const SortKeyColumn &key, const Row &row) const {
+        SortKey k;
+        if (key.codeSlot >= 0) {
+            k.value = key.codeRank[row.codes[key.codeSlot]];
+        } else {
+            const string &value = cellAt(row, key.column);
+            if (value == "null") {
+                k.value = HUGE_VAL;
+            } else if (key.numeric) {
+                k.value = strtod(value.c_str(), nullptr);
+                if (key.integer)
+                    parseInteger(value, k.exact);
+            } else {
+                k.value = key.valueRank.find(value)->second;
+            }
+        }
+        k.null = k.value == HUGE_VAL;
+        if (key.descending) {
+            k.value = -k.value;
+            k.exact = ~k.exact; // -exact - 1, which cannot overflow
+        }
+        return k;
+    }
+    bool zoneMaySatisfy(const ZoneMap &zone, const vector<vector<Condition>> &groups) const {
+        for (const auto &group : groups) {
+            bool possible = true;
+            for (const auto &cond : group) {
+                int c = cond.colIndex;
+                if (c < 0 || c >= (int)zone.stats.columns.size())
+                    continue;
+                if (!zone.stats.columns[c].maySatisfy(cond.op, cond.value, schema[c].numeric)) {
+                    possible = false;
+                    break;
+                }
+            }
+            if (possible)
+                return true;
+        }
+        return false;
+    }
+    void appendLoadedRow(const vector<string> &rowValues) {
+        string pkValue = rowValues[primaryKeyIndex];
+        dataMap[pkValue] = makeRow(rowValues);
+        rowOrder.push_back(pkValue);
+    }
+    // Header row: columnName(DATATYPE)(CONSTRAINT1)...,nextColumn(...)
+    string buildHeaderLine() {
+        string line;
+        for (size_t i = 0; i < headers.size(); i++) {
+            const ColumnSchema &column = schema[i];
+            string headerLine = column.name + "(" + column.typeName + ")";
+            for (const string &constraint : column.constraints)
+                headerLine += "(" + constraint + ")";
+            line += headerLine;
+            if (i < headers.size() - 1)
+                line += ",";
+        }
+        return line;
+    }
+    // Parses the header columns to fill headers, schema and primaryKeyIndex.
+    void parseHeaderLine(const vector<string> &columns) {
+        int colIndex = 0;
+        for (auto &col : columns) {
+            size_t firstParen = col.find('(');
+            size_t firstClose = col.find(')', firstParen);
+            if (firstParen != string::npos && firstClose != string::npos) {
+                // The plain column name is before the first '('.
+                string colName = trim(col.substr(0, firstParen));
+                // Extract the data type from within the first pair of parentheses.
+                string dataType = trim(col.substr(firstParen + 1, firstClose - firstParen - 1));
+                
+                // Extract additional constraints.
+                vector<string> constraints;
+                size_t currentPos = firstClose + 1;
+                while (true) {
+                    size_t open = col.find('(', currentPos);
+                    size_t close = col.find(')', open);
+                    if (open == string::npos || close == string::npos)
+                        break;
+                    string constraint = trim(col.substr(open + 1, close - open - 1));
+                    if (!constraint.empty())
+                        constraints.push_back(constraint);
+                    currentPos = close + 1;
+                }
+                
+                headers.push_back(colName);
+                schema.push_back(ColumnSchema::parse(colName, dataType, constraints));
+                
+                // Check if this column is designated as the PRIMARY key.
+                if (schema.back().has(COLUMN_PRIMARY))
+                    primaryKeyIndex = colIndex;
+                colIndex++;
+            }
+        }
+        if (primaryKeyIndex == -1 && !headers.empty()) {
+            primaryKeyIndex = 0;
+        }
+        buildCellLayout();
+    }
 
     void writeToFile() {
         ofstream file(filename);
@@ -172,45 +677,15 @@ private:
         }
         
         // Write header row.
-        for (size_t i = 0; i < headers.size(); i++) {
-            string colName = headers[i];
-            auto meta = columnMeta[colName];
-            string headerLine = colName + "(" + meta.first + ")";
-            if (!meta.second.empty()) {
-                istringstream ss(meta.second);
-                string constraint;
-                while (getline(ss, constraint, ',')) {
-                    constraint = trim(constraint); // optional: remove spaces
-                    if (!constraint.empty())
-                        headerLine += "(" + constraint + ")";
-                }
-            }
-            file << headerLine;
-            if (i < headers.size() - 1)
-                file << ",";
-        }
-        file << "\n";
+        file << buildHeaderLine() << "\n";
         
         // Write each row in the order defined by rowOrder.
-        // Reconstruct the row based on primaryKeyIndex.
         for (const auto &id : rowOrder)
         {
             auto it = dataMap.find(id);
             if (it != dataMap.end()) {
-                // Reassemble the row in the order specified by headers.
-                // For each column index, if it's the primary key column, use it->first (id);
-                // otherwise, use the corresponding value from it->second.values.
                 for (size_t i = 0; i < headers.size(); i++) {
-                    string cell;
-                    if ((int)i == primaryKeyIndex) {
-                        cell = it->first; // primary key value.
-                    } else if ((int)i < primaryKeyIndex) {
-                        cell = (i < it->second.values.size()) ? it->second.values[i] : "";
-                    } else { // i > primaryKeyIndex: adjust index by subtracting one.
-                        int valIndex = i - 1;
-                        cell = (valIndex < it->second.values.size()) ? it->second.values[valIndex] : "";
-                    }
-                    file << cell;
+                    file << cellAt(it->second, i);
                     if (i < headers.size() - 1)
                         file << ",";
                 }
@@ -219,124 +694,426 @@ private:
         }
         file.close();
     }
-    void writeToFileBinaryAES(const std::string &key) { // no need of specifying key 
-        // Build the CSV-formatted string.
-        std::ostringstream oss;
-        
-        // Build the header row exactly as in writeToFile().
-        for (size_t i = 0; i < headers.size(); i++) {
-            std::string colName = headers[i];
-            auto meta = columnMeta[colName];
-            // Reconstruct header with data type.
-            std::string headerLine = colName + "(" + meta.first + ")";
-            
-            // Append each constraint.
-            if (!meta.second.empty()) {
-                std::istringstream ss(meta.second);
-                std::string constraint;
-                while (getline(ss, constraint, ',')) {
-                    constraint = trim(constraint);  // assuming trim() removes surrounding spaces.
-                    if (!constraint.empty())
-                        headerLine += "(" + constraint + ")";
-                }
-            }
-            oss << headerLine;
-            if (i < headers.size() - 1)
-                oss << ",";
-        }
-        oss << "\n";
-        
-        // Reconstruct each data row as in writeToFile().
+    // Rows in commit order.
+    vector<const Row *> orderedRows() const {
+        vector<const Row *> rows;
+        rows.reserve(rowOrder.size());
         for (const auto &id : rowOrder) {
             auto it = dataMap.find(id);
-            if (it != dataMap.end()) {
-                for (size_t i = 0; i < headers.size(); i++) {
-                    std::string cell;
-                    if ((int)i == primaryKeyIndex) {
-                        cell = it->first; // primary key value.
-                    } else if ((int)i < primaryKeyIndex) {
-                        cell = (i < it->second.values.size()) ? it->second.values[i] : "";
-                    } else { // Adjust for omitted primary key in Row.values.
-                        int valIndex = i - 1;
-                        cell = (valIndex < it->second.values.size()) ? it->second.values[valIndex] : "";
-                    }
-                    oss << cell;
-                    if (i < headers.size() - 1)
-                        oss << ",";
+            if (it != dataMap.end())
+                rows.push_back(&it->second);
+        }
+        return rows;
+    }
+    // Serializes column i of rows [begin, end). A column section starts with
+    // its encoding. Plain columns store one string per row; dictionary columns
+    // store the distinct values used by these rows followed by one code per row.
+    void encodeColumn(ByteWriter &out, const vector<const Row *> &rows, size_t begin, size_t end, size_t i) {
+        if (!schema[i].dictEncoded) {
+            out.putU8(ENCODING_PLAIN);
+            for (size_t r = begin; r < end; r++)
+                out.putString(cellAt(*rows[r], i));
+            return;
+        }
+        // Renumber codes so only the entries referenced by these rows are written.
+        int slot = schema[i].slot;
+        const StringDictionary &dict = dictionaries[slot];
+        vector<uint32_t> localCode(dict.size(), StringDictionary::NOT_FOUND);
+        vector<uint32_t> used;
+        for (size_t r = begin; r < end; r++) {
+            uint32_t code = rows[r]->codes[slot];
+            if (localCode[code] == StringDictionary::NOT_FOUND) {
+                localCode[code] = static_cast<uint32_t>(used.size());
+                used.push_back(code);
+            }
+        }
+        out.putU8(ENCODING_DICTIONARY);
+        out.putU32(static_cast<uint32_t>(used.size()));
+        for (uint32_t code : used)
+            out.putString(dict.valueOf(code));
+        for (size_t r = begin; r < end; r++)
+            out.putU32(localCode[rows[r]->codes[slot]]);
+    }
+    // Inverse of encodeColumn(); sets column i of the given rows.
+    void decodeColumn(ByteReader &in, size_t i, Row *const *rows, size_t rowCount) {
+        uint8_t encoding = in.getU8();
+        if (encoding == ENCODING_PLAIN) {
+            for (size_t r = 0; r < rowCount; r++)
+                setCell(*rows[r], i, in.getString());
+        } else if (encoding == ENCODING_DICTIONARY) {
+            // Map the stored entries into the table dictionary once, then decode codes.
+            uint32_t entryCount = in.getU32();
+            vector<string> entries(entryCount);
+            for (auto &e : entries)
+                e = in.getString();
+            if (!schema[i].dictEncoded) {
+                for (size_t r = 0; r < rowCount; r++) {
+                    uint32_t local = in.getU32();
+                    if (local >= entryCount)
+                        throw runtime_error("program_error: table data is corrupted (bad dictionary code).");
+                    setCell(*rows[r], i, entries[local]);
                 }
-                oss << "\n";
+                return;
             }
+            int slot = schema[i].slot;
+            vector<uint32_t> globalCode(entryCount);
+            for (uint32_t e = 0; e < entryCount; e++)
+                globalCode[e] = dictionaries[slot].intern(entries[e]);
+            for (size_t r = 0; r < rowCount; r++) {
+                uint32_t local = in.getU32();
+                if (local >= entryCount)
+                    throw runtime_error("program_error: table data is corrupted (bad dictionary code).");
+                rows[r]->codes[slot] = globalCode[local];
+            }
+        } else {
+            throw runtime_error("program_error: table data is corrupted (unknown column encoding).");
         }
-        
-        // Convert the CSV data to a string.
-        std::string csvData = oss.str();
-        
-        // Encrypt the CSV data using AES.
-        std::string iv;
-        std::string cipherText = aesEncrypt(csvData, iv);
-        
-        // Write the IV and ciphertext to the binary file.
-        std::ofstream out(filename, std::ios::binary);
-        if (!out.is_open()) {
-            throw std::runtime_error("program_error: could not commit changes (binary write failed).");
-        }
-        // First write the IV (fixed AES_BLOCK_SIZE).
-        out.write(iv.c_str(), AES_BLOCK_SIZE);
-        // Then write the ciphertext.
-        out.write(cipherText.c_str(), cipherText.size());
-        out.close();
-        
-        unsavedChanges = false;
-    }    
-    
-              
-    // Reads metadata from "table_metadata.txt" in the current directory.
-    map<string, int> readTableMetadata(const string &metaFileName = "table_metadata.txt") {
-        map<string, int> metadata;
-        ifstream metaIn(metaFileName);
-        if (!metaIn.is_open()) {
-            // Metadata file might not exist yet; return an empty map.
-            return metadata;
+    }
+    // Rows as written by files that store blocks whole:
+    //   column count | row count | one encodeColumn() section per column.
+    // Appends the decoded rows to the table.
+    void decodeRowsSection(ByteReader &in) {
+        if (in.getU32() != headers.size())
+            throw runtime_error("program_error: table data is corrupted (column count mismatch).");
+        uint64_t rowCount = in.getU64();
+        vector<Row> rows(rowCount);
+        vector<Row *> pointers;
+        for (auto &row : rows) {
+            row.values.resize(valueSlotCount);
+            row.codes.resize(dictionaries.size());
+            pointers.push_back(&row);
         }
-        string line;
-        while (getline(metaIn, line)) {
-            if (line.empty())
+        for (size_t i = 0; i < headers.size(); i++)
+            decodeColumn(in, i, pointers.data(), rows.size());
+        appendDecodedRows(rows);
+    }
+    void appendDecodedRows(vector<Row> &rows) {
+        for (auto &row : rows) {
+            string pkValue = row.id;
+            rowOrder.push_back(pkValue);
+            dataMap[pkValue] = std::move(row);
+        }
+    }
+    // Decodes the columns that are still on disk (see columnSource) for
+    // every row; a no-op for columns already in memory.
+    void ensureColumns(const vector<int> &columns) {
+        ensureRows();
+        if (!columnSource)
+            return;
+        vector<int> missing;
+        for (int c : columns) {
+            if (c >= 0 && c < (int)columnLoaded.size() && !columnLoaded[c] &&
+                find(missing.begin(), missing.end(), c) == missing.end())
+                missing.push_back(c);
+        }
+        if (missing.empty())
+            return;
+        PhaseTimer loading(PHASE_LOAD_IO);
+        // Deleted rows are decoded into a scratch row.
+        Row scratch;
+        scratch.values.resize(valueSlotCount);
+        scratch.codes.resize(dictionaries.size());
+        vector<Row *> rows = storedSlots;
+        for (Row *&row : rows) {
+            if (!row)
+                row = &scratch;
+        }
+        size_t begin = 0;
+        const vector<BlockInfo> &blocks = columnSource->header().blocks;
+        for (size_t b = 0; b < blocks.size(); b++) {
+            if (begin + blocks[b].rowCount > rows.size())
+                throw runtime_error("program_error: table data is corrupted (row count mismatch).");
+            for (int c : missing) {
+                string chunk = columnSource->readChunk(b, c);
+                ByteReader in(chunk);
+                decodeColumn(in, c, rows.data() + begin, blocks[b].rowCount);
+            }
+            begin += blocks[b].rowCount;
+        }
+        for (int c : missing)
+            columnLoaded[c] = 1;
+        closeColumnSourceIfLoaded();
+    }
+    void closeColumnSourceIfLoaded() {
+        if (find(columnLoaded.begin(), columnLoaded.end(), 0) != columnLoaded.end())
+            return;
+        columnSource.reset();
+        storedSlots.clear();
+    }
+    // Decodes the given columns of stored block b.
+    vector<Row> readBlockColumns(size_t b, const vector<size_t> &columns) {
+        vector<Row> rows(columnSource->header().blocks[b].rowCount);
+        vector<Row *> pointers;
+        for (auto &row : rows) {
+            row.values.resize(valueSlotCount);
+            row.codes.resize(dictionaries.size());
+            pointers.push_back(&row);
+        }
+        for (size_t c : columns) {
+            string chunk = columnSource->readChunk(b, c);
+            ByteReader in(chunk);
+            decodeColumn(in, c, pointers.data(), rows.size());
+        }
+        return rows;
+    }
+    vector<Row> readBlockKeys(size_t b) { return readBlockColumns(b, {static_cast<size_t>(primaryKeyIndex)}); }
+    // The key a value of column c is added to block filters under. Integer
+    // primary keys are compared by value, so they are hashed by value too.
+    string filterKey(size_t c, const string &value) const {
+        int64_t key;
+        if ((int)c == primaryKeyIndex && parseInteger(value, key))
+            return to_string(c) + ":" + to_string(key);
+        return to_string(c) + ":" + value;
+    }
+    // Whether a live stored row holds value in UNIQUE column c while the
+    // rows are on disk. Only blocks whose filter can hold value are read.
+    bool storedValueExists(size_t c, const string &value) {
+        string probe = filterKey(c, value);
+        for (size_t b = 0; b < columnSource->blockCount(); b++) {
+            if (!BloomFilter::mayContain(columnSource->header().blocks[b].filter, probe))
                 continue;
-            
-            istringstream iss(line);
-            string tableName, dash, rowsWord;
-            int rowCount;
-            // Expecting the format: tableName - rowCount rows
-            if (iss >> tableName >> dash >> rowCount >> rowsWord) {
-                if (dash == "-" && rowsWord == "rows") {
-                    metadata[tableName] = rowCount;
+            for (const Row &row : readBlockColumns(b, {c, static_cast<size_t>(primaryKeyIndex)})) {
+                if (cellAt(row, c) != value)
+                    continue;
+                auto dead = deadBefore.find(row.id);
+                if (dead == deadBefore.end() || b >= dead->second)
+                    return true;
+            }
+        }
+        return false;
+    }
+    // The key of the live stored row matching id while the rows are on disk,
+    // or "". Only blocks whose key range and filter can hold id are read.
+    string storedKey(const string &id) {
+        int64_t key;
+        bool integer = primaryIndexed && parseInteger(id, key);
+        bool numeric = schema[primaryKeyIndex].numeric;
+        string probe = filterKey(primaryKeyIndex, id);
+        for (size_t b = 0; b < columnSource->blockCount(); b++) {
+            if (zoneMapsValid && b < zoneMaps.size()) {
+                const ColumnStats &range = zoneMaps[b].stats.columns[primaryKeyIndex];
+                if (!range.hasValues || compareCells(id, range.minValue, numeric) < 0 ||
+                    compareCells(id, range.maxValue, numeric) > 0)
+                    continue;
+            }
+            if (!BloomFilter::mayContain(columnSource->header().blocks[b].filter, probe))
+                continue;
+            auto cached = probedKeys.find(b);
+            if (cached == probedKeys.end()) {
+                vector<string> keys;
+                for (Row &row : readBlockKeys(b))
+                    keys.push_back(std::move(row.id));
+                cached = probedKeys.emplace(b, std::move(keys)).first;
+            }
+            for (const string &stored : cached->second) {
+                int64_t v;
+                if (integer ? !(parseInteger(stored, v) && v == key) : stored != id)
+                    continue;
+                auto dead = deadBefore.find(stored);
+                if (dead == deadBefore.end() || b >= dead->second)
+                    return stored;
+            }
+        }
+        return "";
+    }
+    // Whether a row with this primary key exists. Engine lsm answers from
+    // the stored blocks while the rows are on disk.
+    bool keyExists(const string &id) {
+        if (rowsPending && engine == ENGINE_LSM)
+            return findLoadedRow(id) || !storedKey(id).empty();
+        return findRow(id) != nullptr;
+    }
+    // Largest stored integer key, from the block statistics while the rows
+    // are on disk. Without statistics the rows are read instead.
+    bool storedMaxKey(int64_t &key) {
+        if (!zoneMapsValid) {
+            ensureRows();
+            return false;
+        }
+        bool found = false;
+        for (const auto &zone : zoneMaps) {
+            const ColumnStats &range = zone.stats.columns[primaryKeyIndex];
+            int64_t v;
+            if (range.hasValues && parseInteger(range.maxValue, v) && (!found || v > key)) {
+                key = v;
+                found = true;
+            }
+        }
+        return found;
+    }
+    // Reads the primary key of every stored row, in block order, and indexes
+    // the rows; the other columns stay on disk until ensureColumns().
+    // Rows deleted by tombstones are skipped, and rows inserted while the
+    // table was on disk move behind the stored ones.
+    void ensureRows() {
+        if (!rowsPending)
+            return;
+        rowsPending = false;
+        PhaseTimer loading(PHASE_LOAD_IO);
+        vector<string> inserted = std::move(rowOrder);
+        rowOrder.clear();
+        vector<size_t> blockEnd; // rowOrder size after each block
+        for (size_t b = 0; b < columnSource->blockCount(); b++) {
+            for (Row &row : readBlockKeys(b)) {
+                auto dead = deadBefore.find(row.id);
+                if (dead != deadBefore.end() && b < dead->second) {
+                    storedSlots.push_back(nullptr);
+                    continue;
                 }
+                string pkValue = row.id;
+                rowOrder.push_back(pkValue);
+                Row &stored = dataMap[pkValue] = std::move(row);
+                storedSlots.push_back(&stored);
             }
+            blockEnd.push_back(rowOrder.size());
         }
-        metaIn.close();
-        return metadata;
+        size_t stored = rowOrder.size();
+        committedRows += stored;
+        fulltextRows.clear();
+        rowOrder.insert(rowOrder.end(), inserted.begin(), inserted.end());
+        // The stored blocks' statistics still bound their live rows; the
+        // inserted rows get zones of their own.
+        if (zoneMapsValid && zoneMaps.size() == blockEnd.size()) {
+            for (size_t b = 0; b < blockEnd.size(); b++) {
+                zoneMaps[b].begin = b == 0 ? 0 : blockEnd[b - 1];
+                zoneMaps[b].end = blockEnd[b];
+            }
+            vector<const Row *> rows;
+            for (const auto &id : inserted)
+                rows.push_back(&dataMap.find(id)->second);
+            for (size_t begin = 0; begin < rows.size(); begin += ROWS_PER_BLOCK) {
+                size_t end = min(rows.size(), begin + ROWS_PER_BLOCK);
+                zoneMaps.push_back({stored + begin, stored + end, computeBlockStats(rows, begin, end)});
+            }
+        } else {
+            zoneMaps.clear();
+            zoneMapsValid = false;
+        }
+        storedRows = 0;
+        deadBefore.clear();
+        probedKeys.clear();
+        columnLoaded[primaryKeyIndex] = 1;
+        closeColumnSourceIfLoaded();
+        rebuildPrimaryIndex();
+        publishRowCount();
     }
-    
-    // Updates the metadata file with the row count for a given table.
-    // The metadata file is updated with each entry in the following format:
-    // tableName - rowCount rows
-    void updateTableMetadata(const string &metaFileName = "table_metadata.txt") {
-        // Read current metadata.
-        string metaFilePath = (fs::path(fs_path) / currentDatabase / (metaFileName)).string();
-        map<string, int> metadata = readTableMetadata(metaFilePath);
-        // Update the metadata for the provided table.
-        metadata[tableName] = static_cast<int>(rowOrder.size());
-        
-        // Write the updated metadata back to the file.
-        ofstream metaOut(metaFilePath);
-        if (!metaOut.is_open()) {
-            return ;
+    // For statements that change stored rows.
+    void loadForRewrite() {
+        ensureAllColumns();
+        appendable = false;
+    }
+    void ensureAllColumns() {
+        vector<int> all(headers.size());
+        for (size_t i = 0; i < all.size(); i++)
+            all[i] = static_cast<int>(i);
+        ensureColumns(all);
+    }
+    static vector<string> splitHeaderLine(const string &headerLine) {
+        vector<string> columns;
+        stringstream hs(headerLine);
+        string col;
+        while (getline(hs, col, ','))
+            columns.push_back(col);
+        return columns;
+    }
+    // Single-envelope binary payload written before block storage:
+    //   magic | header line | rows section.
+    void decodeTablePayload(const string &payload) {
+        ByteReader in(payload, TABLE_PAYLOAD_MAGIC.size());
+        parseHeaderLine(splitHeaderLine(in.getString()));
+        decodeRowsSection(in);
+    }
+    // Encodes rows [begin, end) as column blocks of at most ROWS_PER_BLOCK
+    // rows; zones receives their statistics. Each block gets a filter of its
+    // primary key and UNIQUE values.
+    void addRowBlocks(TableFileWriter &writer, const vector<const Row *> &rows, size_t begin, size_t end,
+                      vector<ZoneMap> &zones) {
+        for (; begin < end; begin += ROWS_PER_BLOCK) {
+            size_t blockEnd = min(end, begin + ROWS_PER_BLOCK);
+            zones.push_back({begin, blockEnd, computeBlockStats(rows, begin, blockEnd)});
+            vector<string> columns(headers.size());
+            vector<size_t> filtered;
+            for (size_t i = 0; i < headers.size(); i++) {
+                ByteWriter out;
+                encodeColumn(out, rows, begin, blockEnd, i);
+                columns[i] = std::move(out.buffer);
+                if ((int)i == primaryKeyIndex || schema[i].has(COLUMN_UNIQUE))
+                    filtered.push_back(i);
+            }
+            BloomFilter filter((blockEnd - begin) * filtered.size());
+            for (size_t r = begin; r < blockEnd; r++) {
+                for (size_t i : filtered)
+                    filter.add(filterKey(i, cellAt(*rows[r], i)));
+            }
+            writer.addColumnBlock(columns, static_cast<uint32_t>(blockEnd - begin), zones.back().stats.encode(),
+                                  filter.encode());
         }
-        for (const auto &entry : metadata) {
-            // Write in the format: tableName - rowCount rows
-            metaOut << entry.first << " - " << entry.second << " rows" << "\n";
+    }
+    // Writes only the rows inserted since the last commit, and the keys of
+    // the committed rows deleted since (engine lsm), as a segment at the end
+    // of the file. False when the file has to be rewritten instead.
+    bool appendInsertedRows() {
+        string schemaLine = buildHeaderLine();
+        if (!appendable || schemaLine != committedSchema || codec != committedCodec ||
+            appendedSegments >= MAX_APPENDED_SEGMENTS || rowOrder.size() < committedRows)
+            return false;
+        if (rowOrder.size() == committedRows && deletedKeys.empty())
+            return true;
+        vector<const Row *> rows;
+        rows.reserve(rowOrder.size() - committedRows);
+        for (size_t p = committedRows; p < rowOrder.size(); p++)
+            rows.push_back(&dataMap.find(rowOrder[p])->second);
+        TableFileWriter writer(codec, schemaLine, engine);
+        vector<ZoneMap> zones;
+        addRowBlocks(writer, rows, 0, rows.size(), zones);
+        writer.setDeletedKeys(std::move(deletedKeys));
+        deletedKeys.clear();
+        appendOffset = writer.appendTo(filename, appendOffset);
+        appendedSegments++;
+        committedRows = rowOrder.size();
+        return true;
+    }
+    // Writes the table as ROWS_PER_BLOCK sized blocks, each column of a block
+    // compressed with the table codec and encrypted on its own (see
+    // storage.cpp). Every block carries freshly computed column statistics.
+    void writeToFileBinaryAES(const std::string &key) { // no need of specifying key 
+        PhaseTimer writing(PHASE_COMMIT_IO);
+        if (appendInsertedRows()) {
+            unsavedChanges = false;
+            return;
         }
-        metaOut.close();
+        // Full rewrite, which also merges the appended segments.
+        ensureAllColumns();
+        string schemaLine = buildHeaderLine();
+        TableFileWriter writer(codec, schemaLine, engine);
+        vector<const Row *> rows = orderedRows();
+        vector<ZoneMap> written;
+        addRowBlocks(writer, rows, 0, rows.size(), written);
+        uint64_t length = writer.writeTo(filename);
+        zoneMaps = std::move(written);
+        zoneMapsValid = true;
+        appendable = true;
+        committedRows = rows.size();
+        committedSchema = schemaLine;
+        committedCodec = codec;
+        appendOffset = length;
+        appendedSegments = 0;
+        deletedKeys.clear();
+        
+        unsavedChanges = false;
+    }    
+    
+              
+    // Records the schema, row count and file size in the database catalog.
+    void updateCatalog() {
+        CatalogTable entry;
+        entry.schemaLine = buildHeaderLine();
+        entry.engine = engine;
+        entry.codec = codec;
+        entry.rows = rowCount();
+        std::error_code ec;
+        entry.bytes = fs::file_size(filename, ec);
+        catalogPutTable(tableName, entry);
     }
 
 public:
@@ -345,16 +1122,24 @@ public:
     Table(const string &tName) 
       : tableName(tName), filename(tName + ".bin"), columnWidth(15) ,unsavedChanges(false)
     {
+        rowsInMemory = &metricsRegistry().gauge("qilodb_table_rows", "Rows held in memory, by table.",
+                                                "table=\"" + currentDatabase + "/" + tName + "\"");
         retrieveDataBinaryAES(aesKey); // no need of key pass i
+        rebuildPrimaryIndex();
+        publishRowCount();
     }
 
     // Destructor: clear in-memory data to prevent leaks.
     ~Table() {
+        if (rowsInMemory)
+            rowsInMemory->set(0);
         dataMap.clear();
         rowOrder.clear();
         headers.clear();
-        columnMeta.clear();
+        schema.clear();
+        dictionaries.clear();
     }
+    size_t rowCount() const { return (rowsPending ? storedRows : 0) + rowOrder.size(); }
     vector<vector<Condition>> parseAdvancedConditions(const vector<string>& tokens);
     // For checking if a row or column exists.
     bool hasRow(const string &id);
@@ -365,6 +1150,15 @@ public:
     // For deleting rows based on advanced conditions.
     void deleteRowsByAdvancedConditions(const vector<vector<Condition>> &groups);
     bool evaluateAdvancedConditions(const Row &row, const vector<vector<Condition>> &groups);
+    // SHOW with aggregates: count/sum/avg/min/max [WHERE ...] [GROUP BY col].
+    void showAggregates(const vector<string> &tokens);
+    void aggregateRows(const vector<const Row *> &rows, size_t begin, size_t end,
+                       const vector<vector<Condition>> &conditions, int groupColumn,
+                       const vector<AggregateSpec> &aggregates, AggregatePartial &out);
+    // SHOW <cols> FROM <left> JOIN <right> ON <col> = <col> [WHERE ...].
+    static void showJoin(Table &left, Table &right, const vector<string> &select, const vector<string> &clauses);
+    uint64_t joinMask(const Row &row, const vector<vector<vector<Condition>>> &groups);
+    JoinInput joinInput(const vector<vector<vector<Condition>>> &groups);
     // Overload for updating a specified column.
     void updateValueByCondition(const string &colName, const string &oldValue, const string &newValue,
         const vector<vector<Condition>> &conditionGroups);
@@ -379,7 +1173,8 @@ public:
         dataMap.clear();
         rowOrder.clear();
         headers.clear();
-        columnMeta.clear();
+        schema.clear();
+        dictionaries.clear();
         
         // Reset primaryKeyIndex to an invalid value.
         primaryKeyIndex = -1;
@@ -402,56 +1197,10 @@ public:
                 rowValues.push_back(""); //////////////////////// -------------- This is were i can add null while retriving ---------------------- ////////////////////////////////////
             }
             if (isHeader) {
-                // Parse header row to fill headers and columnMeta.
+                // Parse header row to fill headers and schema.
                 // Also detect which column is designated as the PRIMARY_KEY.
-                int colIndex = 0;
-                for (auto &col : rowValues) {
-                    size_t firstParen = col.find('(');
-                    size_t firstClose = col.find(')', firstParen);
-                    if (firstParen != string::npos && firstClose != string::npos) {
-                        // Extract column name and data type.
-                        string colName = trim(col.substr(0, firstParen));
-                        string dataType = trim(col.substr(firstParen + 1, firstClose - firstParen - 1));
-                        // Collect multiple constraints.
-                        vector<string> constraints;
-                        size_t currentPos = firstClose + 1;
-                        while (true) {
-                            size_t open = col.find('(', currentPos);
-                            size_t close = col.find(')', open);
-                            if (open == string::npos || close == string::npos)
-                                break;
-                            string constraint = trim(col.substr(open + 1, close - open - 1));
-                            constraints.push_back(constraint);
-                            currentPos = close + 1;
-                        }
-                        string allConstraints; // ------------------------------------- can be converted here
-                        for (size_t i = 0; i < constraints.size(); ++i) {
-                            allConstraints += constraints[i];
-                            if (i != constraints.size() - 1)
-                                allConstraints += ","; // Join constraints with comma.
-                        }
-                        headers.push_back(colName);
-                        columnMeta[colName] = {dataType, allConstraints};
-                        
-                        // Check if this column is the PRIMARY_KEY.
-                        for (auto &c : constraints) {
-                            if (c == "PRIMARY") {
-                                // Set the primary key index.
-                                primaryKeyIndex = colIndex;
-                                // cout<<primaryKeyIndex;
-                                break;
-                            }
-                        }
-                        colIndex++;
-                    }
-                }
+                parseHeaderLine(rowValues);
                 isHeader = false;
-                // If no primary key was detected, you might want to print an error.
-                if (primaryKeyIndex == -1) {
-                    // cout << "Warning: No PRIMARY_KEY detected in header." << endl;
-                    // thiking of implementing to add a primary column ourselves
-                    // Depending on your design, you could choose to exit here.
-                }
             } else {
                 if (!rowValues.empty()) {
                     // Ensure that the row has as many values as there are headers.
@@ -459,31 +1208,95 @@ public:
                         // cout << "Row skipped: insufficient/more number of columns." << endl;
                         continue;
                     }
-                    // Extract the primary key value using primaryKeyIndex.
-                    string pkValue = rowValues[primaryKeyIndex];
-                    // Build a new vector of values that excludes the primary key column.
-                    vector<string> otherValues;
-                    for (size_t i = 0; i < rowValues.size(); i++) {
-                        if (i == (size_t)primaryKeyIndex)
-                            continue;
-                        otherValues.push_back(rowValues[i]);
-                    }
-                    // Insert into dataMap using the primary key value.
-                    dataMap[pkValue] = Row(pkValue, otherValues);
-                    rowOrder.push_back(pkValue);
+                    appendLoadedRow(rowValues);
                 }
             }
         }
         file.close();
     }
     void retrieveDataBinaryAES(const std::string &key) {
+        PhaseTimer loading(PHASE_LOAD_IO);
+        LatencyTimer timing(tableLoadMetric);
         // Clear current in-memory structures.
         dataMap.clear();
         rowOrder.clear();
         headers.clear();
-        columnMeta.clear();
+        schema.clear();
+        dictionaries.clear();
+        trigramIndexes.clear();
+        fulltextIndexes.clear();
+        columnSource.reset();
+        columnLoaded.clear();
+        storedSlots.clear();
+        rowsPending = false;
+        storedRows = 0;
+        engine = ENGINE_REWRITE;
+        deletedKeys.clear();
+        deadBefore.clear();
+        probedKeys.clear();
+        appendable = false;
+        committedRows = 0;
+        zoneMaps.clear();
+        zoneMapsValid = false;
+        fulltextRows.clear();
         primaryKeyIndex = -1;
         
+        // Block storage: blocks are decrypted and decompressed one at a time.
+        auto reader = make_unique<TableFileReader>();
+        if (reader->open(filename)) {
+            codec = reader->header().codec;
+            engine = reader->header().engine;
+            parseHeaderLine(splitHeaderLine(reader->header().schemaLine));
+            zoneMapsValid = true;
+            // Files stored in column chunks are not decoded here: the row
+            // count and statistics come from the block directory, and
+            // ensureRows() and ensureColumns() read the chunks when needed.
+            bool byColumn = reader->columnar();
+            for (size_t b = 0; b < reader->blockCount(); b++) {
+                size_t begin = byColumn ? storedRows : rowOrder.size();
+                if (byColumn) {
+                    storedRows += reader->header().blocks[b].rowCount;
+                } else {
+                    std::string block = reader->readBlock(b);
+                    ByteReader in(block);
+                    decodeRowsSection(in);
+                }
+                // The stored statistics are reused as long as every block has them.
+                const std::string &stats = reader->header().blocks[b].stats;
+                if (stats.empty()) {
+                    zoneMapsValid = false;
+                    continue;
+                }
+                zoneMaps.push_back({begin, byColumn ? storedRows : rowOrder.size(), BlockStats::decode(stats)});
+                if (zoneMaps.back().stats.columns.size() != headers.size())
+                    zoneMapsValid = false;
+            }
+            if (!zoneMapsValid)
+                zoneMaps.clear();
+            // Each deleted key removes the live row of that key from the
+            // blocks before its segment.
+            for (const auto &segment : reader->header().segments) {
+                for (const string &key : segment.deletedKeys) {
+                    size_t &bound = deadBefore[key];
+                    bound = max(bound, segment.firstBlock);
+                    storedRows--;
+                }
+            }
+            if (byColumn && reader->formatVersion() == TABLE_FILE_VERSION) {
+                appendable = true;
+                committedSchema = reader->header().schemaLine;
+                committedCodec = codec;
+                appendOffset = reader->appendOffset();
+                appendedSegments = reader->segmentCount();
+            }
+            if (byColumn && storedRows > 0) {
+                columnLoaded.assign(headers.size(), 0);
+                rowsPending = true;
+                columnSource = std::move(reader);
+            }
+            return;
+        }
+        
         // Open the binary file.
         std::ifstream in(filename, std::ios::binary);
         if (!in.is_open()) {
@@ -499,11 +1312,16 @@ public:
         std::string cipherText((std::istreambuf_iterator<char>(in)),
                                  std::istreambuf_iterator<char>());
         in.close();
+        bytesReadMetric.add(iv.size() + cipherText.size());
         
-        // Decrypt the CSV data.
+        // Decrypt the table payload.
         std::string csvData = aesDecrypt(cipherText, iv);
+        if (csvData.compare(0, TABLE_PAYLOAD_MAGIC.size(), TABLE_PAYLOAD_MAGIC) == 0) {
+            decodeTablePayload(csvData);
+            return;
+        }
         
-        // Use an istringstream to parse the CSV text.
+        // Legacy payload: plain CSV text. It is rewritten in the binary format on the next commit.
         std::istringstream iss(csvData);
         std::string line;
         bool isHeader = true;
@@ -518,93 +1336,67 @@ public:
             
             if (isHeader) {
                 // Parse header row to extract plain column names and metadata.
-                int colIndex = 0;
-                for (auto &col : rowValues) {
-                    size_t firstParen = col.find('(');
-                    size_t firstClose = col.find(')', firstParen);
-                    if (firstParen != std::string::npos && firstClose != std::string::npos) {
-                        // The plain column name is before the first '('.
-                        std::string colName = trim(col.substr(0, firstParen));
-                        // Extract the data type from within the first pair of parentheses.
-                        std::string dataType = trim(col.substr(firstParen + 1, firstClose - firstParen - 1));
-                        
-                        // Extract additional constraints.
-                        std::vector<std::string> constraints;
-                        size_t currentPos = firstClose + 1;
-                        while (true) {
-                            size_t open = col.find('(', currentPos);
-                            size_t close = col.find(')', open);
-                            if (open == std::string::npos || close == std::string::npos)
-                                break;
-                            std::string constraint = trim(col.substr(open + 1, close - open - 1));
-                            constraints.push_back(constraint);
-                            currentPos = close + 1;
-                        }
-                        
-                        // Rebuild constraints as a comma-separated string.
-                        std::string allConstraints;
-                        for (size_t i = 0; i < constraints.size(); ++i) {
-                            allConstraints += constraints[i];
-                            if (i != constraints.size() - 1)
-                                allConstraints += ",";
-                        }
-                        
-                        headers.push_back(colName);
-                        columnMeta[colName] = {dataType, allConstraints};
-                        
-                        // Check if this column is designated as the PRIMARY key.
-                        for (auto &c : constraints) {
-                            if (c == "PRIMARY") {
-                                primaryKeyIndex = colIndex;
-                                break;
-                            }
-                        }
-                        colIndex++;
-                    }
-                }
+                parseHeaderLine(rowValues);
                 isHeader = false;
-                if (primaryKeyIndex == -1 && !headers.empty()) {
-                    primaryKeyIndex = 0;
-                }
             } else {
                 if (!rowValues.empty()) {
                     // Verify the row has the correct number of columns.
                     if (rowValues.size() != headers.size()) {
                         continue;  // Skip this row.
                     }
-                    // Extract the primary key and construct a row excluding it.
-                    std::string pkValue = rowValues[primaryKeyIndex];
-                    std::vector<std::string> otherValues;
-                    for (size_t i = 0; i < rowValues.size(); i++) {
-                        if ((int)i == primaryKeyIndex)
-                            continue;
-                        otherValues.push_back(rowValues[i]);
-                    }
-                    dataMap[pkValue] = Row(pkValue, otherValues);
-                    rowOrder.push_back(pkValue);
+                    appendLoadedRow(rowValues);
                 }
             }
         }
     }    
     #include <sstream>  // For istringstream
     void updateMetaFile(){
-        updateTableMetadata();
+        updateCatalog();
     }
-    unordered_set<string> parseConstraints(const string &constraintStr) {
-        unordered_set<string> constraints;
-        istringstream ss(constraintStr);
-        string token;
-        
-        while (getline(ss, token, ',')) {
-            token = trim(token);  // Optional: remove leading/trailing spaces
-            if (!token.empty()) {
-                constraints.insert(token);
-            }
+    // Changes the block compression codec; existing data is rewritten on commit.
+    void setCodec(CompressionCodec newCodec) {
+        if (newCodec == codec) {
+            cerr << "WARNING: Table already uses " << codecName(codec) << " compression." << endl;
+            return;
         }
-    
-        return constraints;
+        codec = newCodec;
+        unsavedChanges = true;
+        cout << "\033[32mres: Compression set to " << codecName(codec) << ". Commit to rewrite the table.\033[0m" << endl;
+    }
+    // MAKE FULLTEXT INDEX ON <column>. The index is recorded as a FULLTEXT
+    // constraint in the table header, so it is kept by the next commit.
+    void createFulltextIndex(const string &colName) {
+        auto it = find(headers.begin(), headers.end(), colName);
+        if (it == headers.end())
+            throw invalid_argument("Column \"" + colName + "\" does not exist in table.");
+        ColumnSchema &column = schema[it - headers.begin()];
+        ensureColumns({static_cast<int>(it - headers.begin())});
+        if (!column.dictEncoded)
+            throw ("mismatch_error: FULLTEXT -> column " + colName + " of type " + column.typeName + " is not a text column.");
+        if (column.has(COLUMN_FULLTEXT)) {
+            cerr << "WARNING: Column " << colName << " already has a fulltext index." << endl;
+            return;
+        }
+        column.constraints.push_back("FULLTEXT");
+        column.flags |= COLUMN_FULLTEXT;
+        refreshFulltextIndexes();
+        unsavedChanges = true;
+        cout << "\033[32mres: Fulltext index created on " << colName << ". Commit to keep it.\033[0m" << endl;
     }
     void insertRow(const string &command) {
+        // Only the columns the constraints below read are needed. Engine lsm
+        // checks the primary key and UNIQUE values against the stored blocks
+        // (keyExists, storedValueExists) while the rows are on disk.
+        vector<int> checked;
+        for (size_t i = 0; i < schema.size(); i++) {
+            if ((int)i != primaryKeyIndex &&
+                (schema[i].has(COLUMN_AUTO_INCREMENT) || (schema[i].has(COLUMN_UNIQUE) && engine != ENGINE_LSM)))
+                checked.push_back(static_cast<int>(i));
+        }
+        if (engine != ENGINE_LSM || !checked.empty()) {
+            checked.push_back(primaryKeyIndex);
+            ensureColumns(checked);
+        }
         vector<string> values = extractValues(command);
         // bool allNull = true;
         // for(int i = 0; i < values.size();i++){
@@ -623,53 +1415,41 @@ public:
             throw (errMsg);
         }
         for (size_t i = 0; i < values.size(); i++) {
-            string colName = headers[i];
-            string expectedType = columnMeta[colName].first;
-            string consStr = columnMeta[colName].second;
-            unordered_set<string> consSet = parseConstraints(consStr);
-        
-            
-            // #include <algorithm>  // for std::find_if
+            const ColumnSchema &column = schema[i];
+            const string &colName = column.name;
 
             // check for default
-            auto it = std::find_if(consSet.begin(), consSet.end(), [](const std::string &s) {
-                return s.compare(0, 7, "DEFAULT") == 0;
-            });
-            if (it != consSet.end()) {
-                // Constraint found. Extract the substring after '#'
-                std::string constraint = *it;
-                std::size_t pos = constraint.find('#');
-                if (pos != std::string::npos && pos + 1 < constraint.size()) {
-                    std::string defaultValue = constraint.substr(pos + 1);
-                    if(!validateValue(defaultValue, expectedType)){
-                        throw ("mismatch_error: " + defaultValue + " doesn't match " + colName + " datatype.");
-                    }
-                    // Check for "null" or empty trimmed value before applying the default.
-                    if (values[i] == "null" || trim(values[i]).empty()) {
-                        values[i] = defaultValue;
-                    }
+            if (column.hasDefault) {
+                if (!column.defaultValid) {
+                    throw ("mismatch_error: " + column.defaultValue + " doesn't match " + colName + " datatype.");
+                }
+                // Check for "null" or empty trimmed value before applying the default.
+                if (values[i] == "null" || trim(values[i]).empty()) {
+                    values[i] = column.defaultValue;
                 }
             }
             // Check NOT_NULL constraint.
-            if (consSet.count("NOT_NULL")) {
+            if (column.has(COLUMN_NOT_NULL)) {
                 if (values[i] == "null" || trim(values[i]).empty()) {
                     throw ("Constraint Error: Column '" + colName + "' cannot be null.");
                 }
             }
         
             // Check UNIQUE constraint.
-            if (consSet.count("UNIQUE")) {
+            if (column.has(COLUMN_UNIQUE)) {
+                if ((int)i != primaryKeyIndex && rowsPending && storedValueExists(i, values[i]))
+                    throw ("Constraint Error: Duplicate value '" + values[i] +
+                                        "' found in UNIQUE column '" + colName + "'.");
+                if (!rowsPending)
+                    ensureColumns({static_cast<int>(i)});
+                // A value missing from the column dictionary cannot be a duplicate.
+                bool mayExist = !column.dictEncoded || dictionaries[column.slot].find(values[i]) != StringDictionary::NOT_FOUND;
                 // For the primary key, dataMap keys already hold the value.
                 // For other columns, iterate over all rows.
                 for (const auto &pair : dataMap) {
-                    string existingVal;
-                    if ((int)i == primaryKeyIndex)
-                        existingVal = pair.first;
-                    else {
-                        int idx = (i < (size_t)primaryKeyIndex) ? i : i - 1;
-                        existingVal = (idx < pair.second.values.size()) ? pair.second.values[idx] : "";
-                    }
-                    if (existingVal == values[i]) {
+                    if (!mayExist)
+                        break;
+                    if (cellAt(pair.second, i) == values[i]) {
                         throw ("Constraint Error: Duplicate value '" + values[i] +
                                             "' found in UNIQUE column '" + colName + "'.");
                     }
@@ -677,18 +1457,20 @@ public:
             }
         
             // AUTO_INCREMENT is handled for primary key (and optionally other columns) as in section 3.
-            if (consSet.count("AUTO_INCREMENT") || consSet.count("PRIMARY")) {
-                if (values[i] == "null" || trim(values[i]).empty()) {
+            if (column.has(COLUMN_AUTO_INCREMENT) || column.has(COLUMN_PRIMARY)) {
+                if ((values[i] == "null" || trim(values[i]).empty()) && (int)i == primaryKeyIndex && primaryIndexed) {
+                    int64_t maxKey = 0, storedMax = 0;
+                    bool stored = rowsPending && storedMaxKey(storedMax);
+                    bool any = primaryIndex.maxKey(maxKey);
+                    if (stored)
+                        maxKey = any ? max(maxKey, storedMax) : storedMax;
+                    values[i] = to_string(any || stored ? max<int64_t>(maxKey, 0) + 1 : 1);
+                } else if (values[i] == "null" || trim(values[i]).empty()) {
+                    ensureRows();
                     int maxVal = 0;
                     // Iterate through all rows to find the current maximum value.
                     for (const auto &pair : dataMap) {
-                        string curVal;
-                        if ((int)i == primaryKeyIndex)
-                            curVal = pair.first;
-                        else {
-                            int idx = (i < (size_t)primaryKeyIndex) ? i : i - 1;
-                            curVal = (idx < pair.second.values.size()) ? pair.second.values[idx] : "0";
-                        }
+                        const string &curVal = cellAt(pair.second, i);
                         try {
                             int num = stoi(curVal);
                             maxVal = max(maxVal, num);
@@ -700,14 +1482,14 @@ public:
                 }
             }
             // Also check that the value conforms to the data type.
-            if (!validateValue(values[i], expectedType)) {
+            if (!validateCell(column.validator, values[i])) {
                 throw ("Mismatch Error: Value \"" + values[i] + "\" is not valid for column \"" 
-                                       + colName + "\" of type " + expectedType + ".");
+                                       + colName + "\" of type " + column.typeName + ".");
             }
         }
         // Check primary key constraint
         string pkValue = values[primaryKeyIndex];
-        if (dataMap.find(pkValue) != dataMap.end()) {
+        if (keyExists(pkValue)) {
             throw ("Constraint Error: Primary Key " + pkValue + " already exists.");
             return;
         } 
@@ -731,93 +1513,188 @@ public:
             }
         }
     
-        // Prepare values excluding primary key
-        vector<string> rowValues;
-        for (size_t i = 0; i < values.size(); i++) {
-            if (i == (size_t)primaryKeyIndex)
-                continue;
-            rowValues.push_back(values[i]);
-        }
-    
-        dataMap[pkValue] = Row(pkValue, rowValues);
+        Row &row = dataMap[pkValue] = makeRow(values);
         rowOrder.push_back(pkValue);
+        indexRow(row);
+        extendFulltextRows(row);
+        extendZoneMaps(row);
         unsavedChanges = true;
+        rowsInsertedMetric.add();
+        publishRowCount();
     }
     
+    // Position of a loaded row in rowOrder, which is in Row::sequence order.
+    size_t rowPosition(const Row &row) const {
+        auto it = lower_bound(rowOrder.begin(), rowOrder.end(), row.sequence,
+                              [&](const string &id, uint64_t sequence) { return dataMap.find(id)->second.sequence < sequence; });
+        return it - rowOrder.begin();
+    }
+    // Clears the storedSlots entry of a row that is being removed, so columns
+    // decoded later skip it. The live entries are in Row::sequence order.
+    void releaseStoredSlot(const Row &row) {
+        size_t low = 0, high = storedSlots.size();
+        while (low < high) {
+            size_t mid = low + (high - low) / 2, probe = mid;
+            while (probe < high && !storedSlots[probe])
+                probe++;
+            if (probe == high || storedSlots[probe]->sequence > row.sequence) {
+                high = mid;
+            } else if (storedSlots[probe]->sequence < row.sequence) {
+                low = probe + 1;
+            } else {
+                storedSlots[probe] = nullptr;
+                return;
+            }
+        }
+    }
+    // Columns still on disk are decoded by the commit, which rewrites the file.
     void deleteRow(const string &id) {
-        auto it = dataMap.find(id);
-        if (it != dataMap.end()) {
+        if (engine == ENGINE_LSM) {
+            deleteKey(id);
+            return;
+        }
+        Row *row = findRow(id);
+        if (row) {
+            appendable = false;
+            auto it = dataMap.find(row->id);
+            rowOrder.erase(rowOrder.begin() + rowPosition(*row));
+            releaseStoredSlot(*row);
+            unindexRow(*row);
             dataMap.erase(it);
-            rowOrder.erase(remove(rowOrder.begin(), rowOrder.end(), id), rowOrder.end());
+            zoneMapsValid = false;
+            fulltextRows.clear();
+            publishRowCount();
             // else: silent deletion or custom logic
         }
         unsavedChanges = true;
     }
     
     
+    // Engine lsm: removes one row without reading the table. A committed row
+    // leaves its key as a tombstone for the next commit.
+    void deleteKey(const string &id) {
+        Row *row = findLoadedRow(id);
+        if (!row && rowsPending) {
+            string key = storedKey(id);
+            if (!key.empty()) {
+                deadBefore[key] = SIZE_MAX;
+                deletedKeys.push_back(key);
+                storedRows--;
+            }
+        } else if (row) {
+            string key = row->id;
+            size_t position = rowPosition(*row);
+            if (position < committedRows) {
+                deletedKeys.push_back(key);
+                committedRows--;
+                releaseStoredSlot(*row);
+            }
+            rowOrder.erase(rowOrder.begin() + position);
+            unindexRow(*row);
+            dataMap.erase(key);
+            fulltextRows.clear();
+            if (!rowsPending)
+                zoneMapsValid = false;
+        }
+        unsavedChanges = true;
+        publishRowCount();
+    }
+
     // Clear all rows from the table (keeping headers intact).
     void cleanTable() {
+        columnSource.reset();
+        columnLoaded.clear();
+        storedSlots.clear();
+        rowsPending = false;
+        deletedKeys.clear();
+        deadBefore.clear();
+        probedKeys.clear();
+        appendable = false;
         dataMap.clear();
         rowOrder.clear();
+        primaryIndex.clear();
+        zoneMaps.clear();
+        zoneMapsValid = true;
+        fulltextRows.clear();
         unsavedChanges = true;
+        publishRowCount();
     }   
     void commitTransaction() {
+        PhaseTimer writing(PHASE_COMMIT_IO);
+        LatencyTimer timing(commitLatencyMetric);
+        SyncGroup group;
         writeToFileBinaryAES(aesKey);
-        updateTableMetadata();
+        updateCatalog();
+        group.flush();
         unsavedChanges = false;
         cout << "\033[32mres: Commit successful.\033[0m" << endl;
     }
     void rollbackTransaction() {
         if(unsavedChanges){
             retrieveDataBinaryAES(aesKey);
+            rebuildPrimaryIndex();
+            publishRowCount();
         }else{
             cerr << "WARNING: No changes made to table." << endl;
         }
         cout << "\033[32mres: Rollback successful.\033[0m" << endl;
     }
     void describe() {
+        // Column statistics merged from the block zone maps.
+        ensureZoneMaps();
+        vector<ColumnStats> columnStats(headers.size());
+        for (const auto &zone : zoneMaps) {
+            for (size_t i = 0; i < headers.size(); i++)
+                columnStats[i].merge(zone.stats.columns[i], schema[i].numeric);
+        }
         // Print a header for the description.
         cout << "Table: " << currentTable << "\n";
-        cout << "-------------------------------------------------\n";
+        cout << "Compression: " << codecName(codec) << "\n";
+        cout << "Engine: " << engineName(engine) << "\n";
+        cout << "Rows: " << rowCount() << "\n";
+        cout << "---------------------------------------------------------------------------\n";
         cout <<  "\033[33m" << setw(20) << left << "Column Name" 
              << setw(15) << left << "Data Type"
-             << "Constraints" << "\033[0m\n";
+             << setw(25) << left << "Constraints"
+             << setw(8) << left << "Nulls"
+             << "Distinct" << "\033[0m\n";
             /* 
                 left and setw are I/O manipulators in C++ from the <iomanip> header, 
                 used to format how text is printed to the console 
                 (especially when aligning columns nicely, like in tables).
             */
-        cout << "-------------------------------------------------\n";
+        cout << "---------------------------------------------------------------------------\n";
     
         // Iterate over the headers vector.
-        for (const auto &colName : headers) {
-            // Get data type and constraints from columnMeta.
-            auto metaIt = columnMeta.find(colName);
-            string dataType = (metaIt != columnMeta.end()) ? metaIt->second.first : "\033[31m*None\033[0m";
-            string constraints = (metaIt != columnMeta.end()) ? metaIt->second.second : "\033[31m*None\033[0m";
+        for (size_t i = 0; i < headers.size(); i++) {
+            const string &colName = headers[i];
+            // Get data type and constraints from the column schema.
+            string dataType = schema[i].typeName;
+            string constraints = schema[i].constraintList();
             if(trim(dataType).empty()) dataType = "\033[31mNone\033[0m";
-            if(trim(constraints).empty()) constraints = "\033[31mNone\033[0m";
             cout << setw(20) << left << colName
-                 << setw(15) << left << dataType
-                 << constraints << "\n";
+                 << setw(15) << left << dataType;
+            // Pad before colouring so the escape codes do not count towards the width.
+            if (trim(constraints).empty())
+                cout << "\033[31m" << setw(25) << left << "None" << "\033[0m";
+            else
+                cout << setw(25) << left << constraints;
+            cout << setw(8) << left << columnStats[i].nullCount
+                 << "~" << columnStats[i].distinctEstimate() << "\n";
         }
-        cout << "-------------------------------------------------\n";
+        cout << "---------------------------------------------------------------------------\n";
     }
     
     void show(const string &params) {
         // Tokenize parameters.
-        istringstream iss(params);
-        vector<string> tokens;
-        string token;
-        while (iss >> token)
-            tokens.push_back(token);
+        vector<string> tokens = splitShowParams(params);
         if (tokens.empty()) {
             throw "syntax_error: SHOW -> missing arguments.\n";
         }
         
         // --- Check for LIKE clause ---
         bool likeMode = false;
-        string likePattern;  // prefix pattern for LIKE search (without trailing '*')
+        string likePattern;  // see LikePattern
         // Look for the token "LIKE" (case-insensitive)
         for (size_t i = 0; i < tokens.size(); i++) {
             string t = tokens[i];
@@ -830,8 +1707,6 @@ public:
                     if (!likePattern.empty() && ((likePattern.front() == '"' && likePattern.back() == '"') ||
                                                  (likePattern.front() == '\'' && likePattern.back() == '\'')))
                         likePattern = likePattern.substr(1, likePattern.size() - 2);
-                    if (!likePattern.empty() && likePattern.back() == '*')
-                        likePattern.pop_back();
                 } else {
                     throw ("syntax_error: SHOW -> missing argument for LIKE clause.");
                 }
@@ -840,6 +1715,46 @@ public:
                 break;
             }
         }
+
+        // --- ORDER BY <column> [ASC|DESC] [LIMIT N], always at the end ---
+        unique_ptr<RowSorter> sorter;
+        SortKeyColumn orderKey;
+        for (size_t i = 0; i < tokens.size(); i++) {
+            if (tokens[i] != ORDER)
+                continue;
+            if (i + 2 >= tokens.size() || tokens[i + 1] != BY)
+                throw ("syntax_error: SHOW -> expected ORDER BY <column>.");
+            auto column = find(headers.begin(), headers.end(), tokens[i + 2]);
+            if (column == headers.end())
+                throw ("Column \"" + tokens[i + 2] + "\" not found.\n");
+            size_t next = i + 3;
+            bool descending = false;
+            if (next < tokens.size() && (tokens[next] == ASC || tokens[next] == DESC))
+                descending = tokens[next++] == DESC;
+            int limit = 0;
+            if (next < tokens.size() && tokens[next] == LIMIT) {
+                if (next + 1 >= tokens.size())
+                    throw ("syntax_error: LIMIT -> missing number for LIMIT command.");
+                try {
+                    limit = stoi(tokens[next + 1]);
+                } catch (...) {
+                    throw ("syntax_error: LIMIT -> invalid number for LIMIT command.");
+                }
+                if (limit <= 0)
+                    throw ("syntax_error: LIMIT -> limit must be a positive integer.");
+                next += 2;
+            }
+            if (next < tokens.size())
+                throw ("syntax_error: SHOW -> unexpected \"" + tokens[next] + "\" after ORDER BY.");
+            if (i == 0 || tokens[0] == HEAD || tokens[0] == LIMIT)
+                throw ("syntax_error: SHOW -> ORDER BY needs * or a column list, use ORDER BY <column> LIMIT N.");
+            tokens.erase(tokens.begin() + i, tokens.end());
+            ensureColumns({static_cast<int>(column - headers.begin())});
+            PhaseTimer sorting(PHASE_SORT);
+            orderKey = sortKeyColumn(static_cast<int>(column - headers.begin()), descending);
+            sorter.reset(new RowSorter(limit));
+            break;
+        }
         
         // --- Helper Lambdas in Outer Scope ---
         
@@ -867,22 +1782,34 @@ public:
             auto it = dataMap.find(pk);
             if (it == dataMap.end())
                 return cells;
-            for (size_t i = 0; i < nCols; i++) {
-                string cell;
-                if ((int)i == primaryKeyIndex)
-                    cell = it->first;
-                else if ((int)i < primaryKeyIndex)
-                    cell = (i < it->second.values.size()) ? it->second.values[i] : "";
-                else {
-                    int valIndex = i - 1;
-                    cell = (valIndex < it->second.values.size()) ? it->second.values[valIndex] : "";
-                }
-                cells[i] = cell;
-            }
+            for (size_t i = 0; i < nCols; i++)
+                cells[i] = cellAt(it->second, i);
             return cells;
         };
+        // LIKE is evaluated once per dictionary entry instead of once per row,
+        // for the columns a mode reads once they are decoded.
+        vector<vector<char>> likeHits(nCols);
+        auto prepareLike = [&](const vector<int> &columns) {
+            if (!likeMode)
+                return;
+            PhaseTimer compiling(PHASE_CONDITIONS);
+            LikePattern pattern(likePattern);
+            for (int i : columns) {
+                if (schema[i].dictEncoded)
+                    likeHits[i] = likeMatches(schema[i].slot, pattern);
+            }
+        };
+        // Matches when any of the given string columns matches likePattern.
+        auto rowMatchesLike = [&](const Row &row, const vector<int> &columns) -> bool {
+            for (int colIndex : columns) {
+                if (schema[colIndex].dictEncoded && likeHits[colIndex][row.codes[schema[colIndex].slot]])
+                    return true;
+            }
+            return false;
+        };
         // this is for all columns
         auto print = [&](const bool& printRows, const bool &dir,const int& nor) -> void {
+            PhaseTimer formatting(PHASE_OUTPUT);
             int count = 0;
             int total = rowOrder.size();
             if(nor > total){
@@ -934,6 +1861,9 @@ public:
             }
             cout << "-+\n";
             if(printRows){
+                queryProfile.rowsScanned += nor;
+                queryProfile.rowsMatched += nor;
+                rowsScannedMetric.add(nor);
                 // --- Inline printing each row.
                 if (dir) {
                     for (const auto &pk : rowOrder) {
@@ -970,9 +1900,27 @@ public:
         };
     
         // ----- START: Mode branches that use in-line printing logic -----
-        
+
+        // Mode 0: aggregates, e.g. SHOW count(*), avg(col) [WHERE ...] [GROUP BY col]
+        bool aggregateMode = false;
+        for (const auto &t : tokens) {
+            AggregateFunction function;
+            if (t == WHERE)
+                break;
+            if (t == GROUP || (parseAggregateFunction(t, function) && !hasColumn(t))) {
+                aggregateMode = true;
+                break;
+            }
+        }
+        if (aggregateMode) {
+            if (sorter)
+                throw ("syntax_error: SHOW -> ORDER BY cannot be used with aggregates, groups are shown in order.");
+            if (likeMode)
+                throw ("syntax_error: SHOW -> LIKE cannot be used with aggregates, use WHERE.");
+            showAggregates(tokens);
+        }
         // Mode 1: SHOW * [WHERE/LIKE clauses]
-        if (tokens[0] == "*") {
+        else if (tokens[0] == "*") {
             tokens.erase(tokens.begin()); // remove "*"
             // Check for an optional WHERE clause.
             bool whereClause = false;
@@ -988,51 +1936,35 @@ public:
                 }
             }
             
-            // Lambda for filtering by LIKE (applies to all string columns).
-            auto rowMatchesLike = [&](const vector<string>& cells) -> bool {
-                for (size_t i = 0; i < nCols; i++) {
-                    string dt = columnMeta[headers[i]].first;
-                    if (dt == "VARCHAR" || dt == "CHAR" || dt == "STRING") {
-                        string cell = cells[i];
-                        if (cell.length() >= likePattern.length() &&
-                            cell.substr(0, likePattern.length()) == likePattern)
-                            return true;
-                    }
-                }
-                return false;
-            };
-            // prints the table
-            print(false,true,rowOrder.size());
+            // LIKE applies to all string columns.
+            vector<int> allColumns;
+            for (size_t i = 0; i < nCols; i++)
+                allColumns.push_back(i);
+            ensureAllColumns();
+            prepareLike(allColumns);
             auto condGroups = parseAdvancedConditions(condTokens);
-            for (const auto &pk : rowOrder) {
-                auto it = dataMap.find(pk);
-                vector<string> cells = getRowCells(pk);
-                if (likeMode && !rowMatchesLike(cells))
-                    continue;
-                if (!condTokens.empty() && !evaluateAdvancedConditions(it->second, condGroups))
-                    continue;
-                for (size_t i = 0; i < nCols; i++) {
-                    if(i == 0)
-                        cout << "| ";
-                    else if (i != nCols)
-                        cout << " | ";
-                    cout << setw(colWidths[i]) << left << cells[i];
-                }
-                cout << " |\n";
-            }
-            for (size_t i = 0; i < nCols; i++) {
-                if(i == 0)
-                    cout << "+-";
-                else if (i != nCols)
-                    cout << "-+-";
-                cout << string(colWidths[i], '-');
-                
+            ResultPager pager(headers, [&](const Row &row, size_t column) -> const string & { return cellAt(row, column); });
+            forEachCandidateRow(condGroups, [&](const Row &row) {
+                if (likeMode && !rowMatchesLike(row, allColumns))
+                    return true;
+                if (!condTokens.empty() && !evaluateAdvancedConditions(row, condGroups))
+                    return true;
+                queryProfile.rowsMatched++;
+                if (!sorter)
+                    return pager.add(row);
+                sorter->add(sortKey(orderKey, row), row);
+                return true;
+            });
+            if (sorter) {
+                PhaseTimer sorting(PHASE_SORT);
+                sorter->finish([&](const Row &row) { return pager.add(row); });
             }
-            cout << "-+\n";
+            pager.finish();
         }
         // Mode 2: HEAD - Display header and first 5 rows (using the same in-line printing logic)
         else if (tokens[0] == HEAD) {
             int defaultLimit = 5;
+            ensureAllColumns();
             print(true,true,defaultLimit);
         }
         // Mode 3: LIMIT - Display header and a limited number of rows.
@@ -1055,6 +1987,7 @@ public:
             if (limit <= 0) {
                 throw ("syntax_error: LIMIT -> limit must be a positive integer.");
             }
+            ensureAllColumns();
             print(true,!fromBottom,limit);
         }
         // Mode 4: SHOW specific columns with optional WHERE/LIKE filtering.
@@ -1063,7 +1996,7 @@ public:
             // Instead of joining tokens, treat each token before a WHERE/LIKE as a separate column spec.
             vector<string> selectedColumns;
             int clauseIndex = -1;
-            for (int i = 0; i < tokens.size(); i++) {
+            for (int i = 0; i < (int)tokens.size(); i++) {
                 string token = tokens[i];
                 if (token == WHERE) {
                     clauseIndex = i;
@@ -1099,8 +2032,6 @@ public:
                             ((likePattern.front() == '"' && likePattern.back() == '"') ||
                              (likePattern.front() == '\'' && likePattern.back() == '\'')))
                             likePattern = likePattern.substr(1, likePattern.size() - 2);
-                        if (!likePattern.empty() && likePattern.back() == '*')
-                            likePattern.pop_back();
                     } else {
                         throw ("syntax_error: SHOW -> missing argument for LIKE clause.");
                     }
@@ -1112,7 +2043,7 @@ public:
             vector<int> colIndices;
             for (auto &colName : selectedColumns) {
                 int colIndex = -1;
-                for (int i = 0; i < headers.size(); i++) {
+                for (int i = 0; i < (int)headers.size(); i++) {
                     if (headers[i] == colName) {
                         colIndex = i;
                         break;
@@ -1124,108 +2055,32 @@ public:
                 colIndices.push_back(colIndex);
             }
             
-            // Compute dynamic widths for selected columns.
-            size_t nSelected = colIndices.size();
-            vector<size_t> selColWidths(nSelected, 0);
-            for (size_t i = 0; i < nSelected; i++) {
-                selColWidths[i] = headers[colIndices[i]].length();
-            }
-            
-            auto getCellValue = [&](const Row &row, int colIndex) -> string {
-                string cell;
-                if (colIndex == primaryKeyIndex)
-                    cell = row.id;
-                else if (colIndex < primaryKeyIndex)
-                    cell = (colIndex < row.values.size()) ? row.values[colIndex] : "";
-                else {
-                    int valIndex = colIndex - 1;
-                    cell = (valIndex < row.values.size()) ? row.values[valIndex] : "";
-                }
-                return cell;
-            };
-            
-            // Update widths based on row content.
-            for (const auto &pk : rowOrder) {
-                auto it = dataMap.find(pk);
-                if (it == dataMap.end()) continue;
-                for (size_t i = 0; i < nSelected; i++) {
-                    string cell = getCellValue(it->second, colIndices[i]);
-                    selColWidths[i] = max(selColWidths[i], cell.length());
-                }
-            }
-            
-            // Re-use the center lambda.
-            auto centerSel = [&](const string &s, size_t width) -> string {
-                if (s.length() >= width)
-                    return s;
-                size_t leftPadding = (width - s.length()) / 2;
-                size_t rightPadding = width - s.length() - leftPadding;
-                return string(leftPadding, ' ') + s + string(rightPadding, ' ');
-            };
-            
-            // Print header row (centered) for selected columns.
-            cout << endl;
-            for (size_t i = 0; i < selectedColumns.size(); i++) {
-                if (i == 0) cout << "+-";
-                else if (i != selectedColumns.size()) cout << "-+-";
-                cout << string(selColWidths[i], '-');
-            }
-            cout << "-+\n";
-            for (size_t i = 0; i < selectedColumns.size(); i++) {
-                if (i == 0) cout << "| ";
-                else if(i != selectedColumns.size()) cout << " | ";
-                cout << "\033[33m" << centerSel(selectedColumns[i], selColWidths[i]) << "\033[0m";
-            }
-            cout << " |\n";
-            for (size_t i = 0; i < selectedColumns.size(); i++) {
-                if (i == 0) cout << "+-";
-                else if (i != selectedColumns.size()) cout << "-+-";
-                cout << string(selColWidths[i], '-');
-            }
-            cout << "-+\n";
-            
+            ensureColumns(colIndices);
+            prepareLike(colIndices);
             // Parse WHERE conditions if extraTokens exist.
             vector<vector<Condition>> conditionGroups;
             if (!extraTokens.empty())
                 conditionGroups = parseAdvancedConditions(extraTokens);
             
-            // For LIKE filtering on selected columns.
-            auto rowMatchesLikeSel = [&](const Row &row) -> bool {
-                for (int colIndex : colIndices) {
-                    string dt = columnMeta[headers[colIndex]].first;
-                    if (dt == "VARCHAR" || dt == "CHAR" || dt == "STRING") {
-                        string cell = getCellValue(row, colIndex);
-                        if (cell.length() >= likePattern.length() &&
-                            cell.substr(0, likePattern.length()) == likePattern)
-                            return true;
-                    }
-                }
-                return false;
-            };
-            
-            // Print each row.
-            for (const auto &pk : rowOrder) {
-                auto it = dataMap.find(pk);
-                if (it == dataMap.end())
-                    continue;
-                if (!conditionGroups.empty() && !evaluateAdvancedConditions(it->second, conditionGroups))
-                    continue;
-                if (likeMode && !rowMatchesLikeSel(it->second))
-                    continue;
-                for (size_t i = 0; i < nSelected; i++) {
-                    string cell = getCellValue(it->second, colIndices[i]);
-                    if(i == 0) cout << "| ";
-                    else if (i != nCols) cout << " | ";
-                    cout << setw(selColWidths[i]) << left << cell;
-                }
-                cout << " |\n";
-            }
-            for (size_t i = 0; i < selectedColumns.size(); i++) {
-                if (i == 0) cout << "+-";
-                else if (i != selectedColumns.size()) cout << "-+-";
-                cout << string(selColWidths[i], '-');
+            ResultPager pager(selectedColumns, [&](const Row &row, size_t column) -> const string & {
+                return cellAt(row, colIndices[column]);
+            });
+            forEachCandidateRow(conditionGroups, [&](const Row &row) {
+                if (!conditionGroups.empty() && !evaluateAdvancedConditions(row, conditionGroups))
+                    return true;
+                if (likeMode && !rowMatchesLike(row, colIndices))
+                    return true;
+                queryProfile.rowsMatched++;
+                if (!sorter)
+                    return pager.add(row);
+                sorter->add(sortKey(orderKey, row), row);
+                return true;
+            });
+            if (sorter) {
+                PhaseTimer sorting(PHASE_SORT);
+                sorter->finish([&](const Row &row) { return pager.add(row); });
             }
-            cout << "-+\n";
+            pager.finish();
         }
     }
     // End of show() function.
@@ -1233,7 +2088,7 @@ public:
 };
     
 bool Table::hasRow(const string &id) {
-    return dataMap.find(id) != dataMap.end();
+    return keyExists(id);
 }
 
 bool Table::hasColumn(const string &colName) {
@@ -1244,9 +2099,10 @@ bool Table::hasColumn(const string &colName) {
     return false;
 }
 void Table::deleteColumn(const string &colName) {
+    loadForRewrite();
     // Find the column index.
     int colIndex = -1;
-    for (int i = 0; i < headers.size(); i++) {
+    for (int i = 0; i < (int)headers.size(); i++) {
         if (headers[i] == colName) {
             colIndex = i;
             break;
@@ -1255,31 +2111,70 @@ void Table::deleteColumn(const string &colName) {
     if (colIndex == primaryKeyIndex) {  // Prevent deletion of primary key.
         throw invalid_argument("Primary key column cannot be deleted.");
     }
+    int slot = schema[colIndex].slot;
+    bool coded = schema[colIndex].dictEncoded;
     // Remove from headers and metadata.
     headers.erase(headers.begin() + colIndex);
-    columnMeta.erase(colName);
+    schema.erase(schema.begin() + colIndex);
+    if (colIndex < primaryKeyIndex)
+        primaryKeyIndex--;
     // Remove the corresponding value from each row.
     for (auto &pair : dataMap) {
-        if (pair.second.values.size() >= colIndex)
-            pair.second.values.erase(pair.second.values.begin() + (colIndex - 1));
+        if (coded && slot < (int)pair.second.codes.size())
+            pair.second.codes.erase(pair.second.codes.begin() + slot);
+        else if (!coded && slot < (int)pair.second.values.size())
+            pair.second.values.erase(pair.second.values.begin() + slot);
     }
+    if (coded)
+        dictionaries.erase(dictionaries.begin() + slot);
+    buildCellLayout();
+    zoneMapsValid = false;
     cout << "\033[32mres: Column \"" << colName << "\" deleted successfully.\033[0m" << endl;
     unsavedChanges = true;
 }
 void Table::deleteRowsByAdvancedConditions(const vector<vector<Condition>> &groups) {
+    if (engine == ENGINE_LSM)
+        ensureRows();
+    else
+        loadForRewrite();
     vector<string> rowsToDelete;
 
-    for (const auto &id : rowOrder) {
-        auto it = dataMap.find(id);
-        if (it != dataMap.end() && evaluateAdvancedConditions(it->second, groups)) {
-            rowsToDelete.push_back(id);
+    forEachCandidateRow(groups, [&](const Row &row) {
+        if (evaluateAdvancedConditions(row, groups)) {
+            queryProfile.rowsMatched++;
+            rowsToDelete.push_back(row.id);
+        }
+    });
+    // Delete the rows that satisfy the condition, with one pass over rowOrder.
+    unordered_set<string_view> doomed(rowsToDelete.begin(), rowsToDelete.end());
+    if (engine == ENGINE_LSM) {
+        // Committed rows are saved as tombstones by the next commit.
+        size_t committedDeleted = 0;
+        for (size_t p = 0; p < committedRows; p++) {
+            if (doomed.count(rowOrder[p])) {
+                deletedKeys.push_back(rowOrder[p]);
+                committedDeleted++;
+            }
+        }
+        committedRows -= committedDeleted;
+        for (Row *&slot : storedSlots) {
+            if (slot && doomed.count(slot->id))
+                slot = nullptr;
         }
     }
-    // Delete the rows that satisfy the condition.
+    rowOrder.erase(remove_if(rowOrder.begin(), rowOrder.end(),
+                             [&](const string &id) { return doomed.count(id) > 0; }),
+                   rowOrder.end());
     for (const auto &id : rowsToDelete) {
-        dataMap.erase(id);
-        rowOrder.erase(remove(rowOrder.begin(), rowOrder.end(), id), rowOrder.end());
+        auto it = dataMap.find(id);
+        unindexRow(it->second);
+        dataMap.erase(it);
+    }
+    if (!rowsToDelete.empty()) {
+        zoneMapsValid = false;
+        fulltextRows.clear();
     }
+    publishRowCount();
     cout <<"\033[32mres: " << rowsToDelete.size() << " row(s) affected.\033[0m" << endl;
     unsavedChanges = true;
 }
@@ -1289,28 +2184,35 @@ bool Table::evaluateAdvancedConditions(const Row &row, const vector<vector<Condi
         bool groupSatisfied = true;
         for (const auto &cond : group) {
             // Locate the column index.
-            int colIndex = -1;
-            for (int i = 0; i < headers.size(); i++) {
-                if (headers[i] == cond.column) {
-                    colIndex = i;
-                    break;
+            int colIndex = cond.colIndex;
+            if (colIndex == -1) {
+                for (int i = 0; i < (int)headers.size(); i++) {
+                    if (headers[i] == cond.column) {
+                        colIndex = i;
+                        break;
+                    }
                 }
             }
             if (colIndex == -1) { groupSatisfied = false; break; }
-            string actual;
-            if (colIndex == primaryKeyIndex) {
-                actual = row.id;
-            } 
-            else if (colIndex < primaryKeyIndex) {
-                // Before the primary key: use the same index.
-                actual = (colIndex < row.values.size()) ? row.values[colIndex] : "";
-            } 
-            else {  // colIndex > primaryKeyIndex
-                // After the primary key: the mapping is offset by one.
-                int idx = colIndex - 1;
-                actual = (idx < row.values.size()) ? row.values[idx] : "";
-            }
-            if (!compareValues(actual, cond.op, cond.value)) {
+            if (cond.textHits) {
+                uint32_t code = row.codes[schema[colIndex].slot];
+                if (code >= cond.textHits->size() || !(*cond.textHits)[code]) {
+                    groupSatisfied = false;
+                    break;
+                }
+                continue;
+            }
+            // Equality on an encoded column compares dictionary codes.
+            if (schema[colIndex].dictEncoded && cond.colIndex != -1 && (cond.op == "=" || cond.op == "!=")) {
+                bool equal = cond.code != StringDictionary::NOT_FOUND &&
+                             row.codes[schema[colIndex].slot] == cond.code;
+                if (equal != (cond.op == "=")) {
+                    groupSatisfied = false;
+                    break;
+                }
+                continue;
+            }
+            if (!compareValues(cellAt(row, colIndex), cond.op, cond.value, schema[colIndex].numeric)) {
                 groupSatisfied = false;
                 break;
             }
@@ -1321,7 +2223,470 @@ bool Table::evaluateAdvancedConditions(const Row &row, const vector<vector<Condi
     return false;
 }
 
+void Table::aggregateRows(const vector<const Row *> &rows, size_t begin, size_t end,
+                          const vector<vector<Condition>> &conditions, int groupColumn,
+                          const vector<AggregateSpec> &aggregates, AggregatePartial &out) {
+    static const size_t BATCH_ROWS = 1024;
+    bool groupByCode = groupColumn >= 0 && groupColumn != primaryKeyIndex && schema[groupColumn].dictEncoded;
+    // Numeric columns read by the aggregates, decoded once per batch.
+    vector<int> numericColumns;
+    for (const auto &spec : aggregates) {
+        if (spec.function != AGG_COUNT && spec.numeric &&
+            find(numericColumns.begin(), numericColumns.end(), spec.column) == numericColumns.end())
+            numericColumns.push_back(spec.column);
+    }
+    vector<const Row *> batch;
+    vector<uint32_t> groupOf;
+    vector<vector<int64_t>> integers(numericColumns.size());
+    vector<vector<double>> numbers(numericColumns.size());
+    vector<vector<char>> present(numericColumns.size());
+    batch.reserve(BATCH_ROWS);
+    groupOf.reserve(BATCH_ROWS);
+
+    for (size_t start = begin; start < end; start += BATCH_ROWS) {
+        batch.clear();
+        groupOf.clear();
+        size_t stop = min(end, start + BATCH_ROWS);
+        for (size_t r = start; r < stop; r++) {
+            if (conditions.empty() || evaluateAdvancedConditions(*rows[r], conditions))
+                batch.push_back(rows[r]);
+        }
+        if (batch.empty())
+            continue;
+        out.matched += batch.size();
+
+        for (const Row *row : batch) {
+            uint32_t group = 0;
+            if (groupByCode)
+                group = row->codes[schema[groupColumn].slot];
+            else if (groupColumn >= 0)
+                group = out.groupOf(cellAt(*row, groupColumn));
+            groupOf.push_back(group);
+        }
+        if (groupByCode)
+            out.ensureGroups(dictionaries[schema[groupColumn].slot].size());
+        for (uint32_t group : groupOf)
+            out.groupRows[group]++;
+
+        for (size_t c = 0; c < numericColumns.size(); c++) {
+            int col = numericColumns[c];
+            bool integer = schema[col].type == TYPE_INT || schema[col].type == TYPE_BIGINT;
+            integers[c].resize(batch.size());
+            numbers[c].resize(batch.size());
+            present[c].resize(batch.size());
+            for (size_t i = 0; i < batch.size(); i++) {
+                const string &cell = cellAt(*batch[i], col);
+                present[c][i] = cell != "null";
+                if (!present[c][i])
+                    continue;
+                if (integer)
+                    present[c][i] = parseInteger(cell, integers[c][i]);
+                else
+                    numbers[c][i] = strtod(cell.c_str(), nullptr);
+            }
+        }
+
+        for (size_t a = 0; a < aggregates.size(); a++) {
+            const AggregateSpec &spec = aggregates[a];
+            if (spec.column < 0) {
+                for (size_t i = 0; i < batch.size(); i++)
+                    out.at(groupOf[i], a).count++;
+            } else if (spec.function == AGG_COUNT) {
+                for (size_t i = 0; i < batch.size(); i++) {
+                    if (cellAt(*batch[i], spec.column) != "null")
+                        out.at(groupOf[i], a).count++;
+                }
+            } else if (spec.numeric) {
+                size_t c = find(numericColumns.begin(), numericColumns.end(), spec.column) - numericColumns.begin();
+                for (size_t i = 0; i < batch.size(); i++) {
+                    if (!present[c][i])
+                        continue;
+                    if (spec.integer)
+                        out.at(groupOf[i], a).addInteger(integers[c][i]);
+                    else
+                        out.at(groupOf[i], a).addNumber(numbers[c][i]);
+                }
+            } else {
+                for (size_t i = 0; i < batch.size(); i++) {
+                    const string &cell = cellAt(*batch[i], spec.column);
+                    if (cell != "null")
+                        out.at(groupOf[i], a).addText(&cell);
+                }
+            }
+        }
+    }
+}
+
+void Table::showAggregates(const vector<string> &tokens) {
+    auto columnIndex = [&](const string &name) -> int {
+        auto it = find(headers.begin(), headers.end(), name);
+        if (it == headers.end())
+            throw ("Column \"" + name + "\" not found.\n");
+        return static_cast<int>(it - headers.begin());
+    };
+    // Select list, up to WHERE or GROUP BY: aggregates and the group column.
+    size_t pos = 0;
+    vector<AggregateSpec> aggregates;
+    vector<int> outputs; // index into aggregates, -1 for the group column
+    vector<string> plainColumns;
+    while (pos < tokens.size() && tokens[pos] != WHERE && tokens[pos] != GROUP) {
+        AggregateFunction function;
+        if (!parseAggregateFunction(tokens[pos], function) || hasColumn(tokens[pos])) {
+            plainColumns.push_back(tokens[pos++]);
+            outputs.push_back(-1);
+            continue;
+        }
+        if (pos + 1 >= tokens.size())
+            throw ("syntax_error: SHOW -> missing argument for " + tokens[pos] + ".");
+        AggregateSpec spec;
+        spec.function = function;
+        spec.label = tokens[pos] + "(" + tokens[pos + 1] + ")";
+        if (tokens[pos + 1] == "*") {
+            if (function != AGG_COUNT)
+                throw ("syntax_error: SHOW -> only count accepts *.");
+        } else {
+            spec.column = columnIndex(tokens[pos + 1]);
+            spec.numeric = schema[spec.column].numeric;
+            spec.integer = schema[spec.column].type == TYPE_INT || schema[spec.column].type == TYPE_BIGINT;
+            if ((function == AGG_SUM || function == AGG_AVG) && !spec.numeric)
+                throw ("invalid_argument: " + spec.label + " needs a numeric column.");
+        }
+        outputs.push_back(static_cast<int>(aggregates.size()));
+        aggregates.push_back(spec);
+        pos += 2;
+    }
+    vector<string> condTokens;
+    if (pos < tokens.size() && tokens[pos] == WHERE) {
+        for (pos++; pos < tokens.size() && tokens[pos] != GROUP; pos++)
+            condTokens.push_back(tokens[pos]);
+        if (condTokens.empty())
+            throw ("syntax_error: SHOW -> WHERE clause provided but missing conditions.");
+    }
+    int groupColumn = -1;
+    if (pos < tokens.size()) {
+        if (pos + 3 != tokens.size() || tokens[pos + 1] != BY)
+            throw ("syntax_error: SHOW -> expected GROUP BY <column> at the end.");
+        groupColumn = columnIndex(tokens[pos + 2]);
+    }
+    if (aggregates.empty())
+        throw ("syntax_error: SHOW -> GROUP BY needs at least one aggregate.");
+    for (const string &column : plainColumns) {
+        if (groupColumn < 0 || column != headers[groupColumn])
+            throw ("syntax_error: SHOW -> \"" + column + "\" must be the GROUP BY column or inside an aggregate.");
+    }
+    if (groupColumn >= 0 && plainColumns.empty())
+        outputs.insert(outputs.begin(), -1);
+
+    vector<int> used;
+    for (const auto &spec : aggregates)
+        used.push_back(spec.column);
+    used.push_back(groupColumn);
+    ensureColumns(used);
+    auto conditionGroups = parseAdvancedConditions(condTokens);
+    vector<const Row *> candidates;
+    forEachCandidateRow(conditionGroups, [&](const Row &row) { candidates.push_back(&row); });
+
+    // One partial per worker, merged into the first.
+    bool groupByCode = groupColumn >= 0 && groupColumn != primaryKeyIndex && schema[groupColumn].dictEncoded;
+    size_t initialGroups = groupByCode ? dictionaries[schema[groupColumn].slot].size() : (groupColumn < 0 ? 1 : 0);
+    size_t workers = min<size_t>(thread::hardware_concurrency(), candidates.size() / PARALLEL_AGGREGATE_MIN);
+    workers = max<size_t>(workers, 1);
+    vector<AggregatePartial> partials(workers, AggregatePartial(aggregates.size(), initialGroups));
+    {
+        PhaseTimer scanning(PHASE_SCAN);
+        vector<thread> threads;
+        for (size_t w = 1; w < workers; w++) {
+            threads.emplace_back([&, w] {
+                aggregateRows(candidates, candidates.size() * w / workers, candidates.size() * (w + 1) / workers,
+                              conditionGroups, groupColumn, aggregates, partials[w]);
+            });
+        }
+        aggregateRows(candidates, 0, candidates.size() / workers, conditionGroups, groupColumn, aggregates,
+                      partials[0]);
+        for (auto &t : threads)
+            t.join();
+        for (size_t w = 1; w < workers; w++)
+            partials[0].merge(partials[w], groupColumn >= 0 && !groupByCode);
+    }
+    AggregatePartial &result = partials[0];
+    queryProfile.rowsMatched += result.matched;
+
+    PhaseTimer formatting(PHASE_OUTPUT);
+    vector<uint32_t> groups;
+    for (uint32_t g = 0; g < result.groupRows.size(); g++) {
+        if (groupColumn < 0 || result.groupRows[g] > 0)
+            groups.push_back(g);
+    }
+    auto groupValue = [&](uint32_t g) -> string {
+        if (groupByCode)
+            return dictionaries[schema[groupColumn].slot].valueOf(g);
+        return string(result.groupValues[g]);
+    };
+    if (groupColumn >= 0) {
+        bool numeric = schema[groupColumn].numeric;
+        sort(groups.begin(), groups.end(), [&](uint32_t a, uint32_t b) {
+            string x = groupValue(a), y = groupValue(b);
+            if ((x == "null") != (y == "null"))
+                return y == "null";
+            return compareCells(x, y, numeric) < 0;
+        });
+    }
+    vector<string> header;
+    for (int o : outputs)
+        header.push_back(o < 0 ? headers[groupColumn] : aggregates[o].label);
+    vector<vector<string>> rows;
+    for (uint32_t g : groups) {
+        vector<string> cells;
+        for (int o : outputs)
+            cells.push_back(o < 0 ? groupValue(g) : renderAggregate(aggregates[o], result.at(g, o)));
+        rows.push_back(cells);
+    }
+    printResultTable(header, rows);
+}
+
+uint64_t Table::joinMask(const Row &row, const vector<vector<vector<Condition>>> &groups) {
+    uint64_t mask = 0;
+    for (size_t g = 0; g < groups.size(); g++) {
+        if (groups[g][0].empty() || evaluateAdvancedConditions(row, groups[g]))
+            mask |= uint64_t(1) << g;
+    }
+    return mask;
+}
+
+JoinInput Table::joinInput(const vector<vector<vector<Condition>>> &groups) {
+    // Zone maps can only skip blocks when every OR group has a condition here.
+    vector<vector<Condition>> pruning;
+    for (const auto &group : groups) {
+        if (group[0].empty()) {
+            pruning.clear();
+            break;
+        }
+        pruning.push_back(group[0]);
+    }
+    JoinInput input;
+    forEachCandidateRow(pruning, [&](const Row &row) {
+        uint64_t mask = joinMask(row, groups);
+        if (mask) {
+            input.rows.push_back(&row);
+            input.masks.push_back(mask);
+        }
+    });
+    return input;
+}
+
+void Table::showJoin(Table &left, Table &right, const vector<string> &select, const vector<string> &clauses) {
+    Table *tables[2] = {&left, &right};
+    auto resolve = [&](const string &name) -> JoinColumn {
+        JoinColumn ref;
+        ref.label = name;
+        size_t dot = name.find('.');
+        for (int side = 0; side < 2; side++) {
+            const Table &table = *tables[side];
+            string column = name;
+            if (dot != string::npos) {
+                if (name.compare(0, dot, table.tableName) != 0 || table.tableName.size() != dot)
+                    continue;
+                column = name.substr(dot + 1);
+            }
+            auto it = find(table.headers.begin(), table.headers.end(), column);
+            if (it == table.headers.end())
+                continue;
+            if (ref.column >= 0)
+                throw ("syntax_error: SHOW -> column \"" + name + "\" is in both tables, use <table>." + name + ".");
+            ref.side = static_cast<JoinSide>(side);
+            ref.column = static_cast<int>(it - table.headers.begin());
+        }
+        if (ref.column < 0)
+            throw ("Column \"" + name + "\" not found.\n");
+        return ref;
+    };
+
+    for (const string &token : clauses) {
+        if (token == ORDER || token == GROUP || token == LIKE)
+            throw ("syntax_error: SHOW -> " + token + " cannot be used with a join.");
+    }
+    vector<JoinColumn> outputs;
+    if (select.size() == 1 && select[0] == "*") {
+        for (int side = 0; side < 2; side++) {
+            for (size_t c = 0; c < tables[side]->headers.size(); c++)
+                outputs.push_back({static_cast<JoinSide>(side), static_cast<int>(c),
+                                   tables[side]->tableName + "." + tables[side]->headers[c]});
+        }
+    } else {
+        for (const string &name : select) {
+            AggregateFunction function;
+            if (name == "*")
+                throw ("syntax_error: SHOW -> * cannot be combined with columns.");
+            if (parseAggregateFunction(name, function) && !left.hasColumn(name) && !right.hasColumn(name))
+                throw ("syntax_error: SHOW -> aggregates cannot be used with a join.");
+            outputs.push_back(resolve(name));
+        }
+    }
+    if (outputs.empty())
+        throw ("syntax_error: SHOW -> no columns specified.");
+
+    // ON <column> = <column>, one of each table.
+    if (clauses.size() < 4 || clauses[0] != ON || clauses[2] != "=")
+        throw ("syntax_error: SHOW -> expected ON <table>.<column> = <table>.<column> after JOIN.");
+    JoinColumn on[2] = {resolve(clauses[1]), resolve(clauses[3])};
+    if (on[0].side == on[1].side)
+        throw ("syntax_error: SHOW -> ON must compare a column of each table.");
+    int joinColumn[2];
+    joinColumn[on[0].side] = on[0].column;
+    joinColumn[on[1].side] = on[1].column;
+    vector<string> condTokens;
+    if (clauses.size() > 4) {
+        if (clauses[4] != WHERE)
+            throw ("syntax_error: SHOW -> unexpected \"" + clauses[4] + "\" after ON.");
+        condTokens.assign(clauses.begin() + 5, clauses.end());
+        if (condTokens.empty())
+            throw ("syntax_error: SHOW -> WHERE clause provided but missing conditions.");
+    }
+
+    // Every OR group is split into its conditions on either table, so that
+    // each table filters its own rows before the join.
+    vector<vector<string>> groupTokens[2] = {vector<vector<string>>(1), vector<vector<string>>(1)};
+    for (size_t i = 0; i < condTokens.size();) {
+        if (i + 2 >= condTokens.size())
+            throw invalid_argument("Not enough arguments to form a condition.");
+        JoinColumn column = resolve(condTokens[i]);
+        vector<string> &target = groupTokens[column.side].back();
+        target.push_back(tables[column.side]->headers[column.column]);
+        target.push_back(condTokens[i + 1]);
+        target.push_back(condTokens[i + 2]);
+        i += 3;
+        if (i < condTokens.size() && condTokens[i] == AND)
+            i++;
+        if (i < condTokens.size() && condTokens[i] == OR) {
+            groupTokens[JOIN_LEFT].emplace_back();
+            groupTokens[JOIN_RIGHT].emplace_back();
+            i++;
+        }
+    }
+    if (groupTokens[JOIN_LEFT].size() > JOIN_MAX_OR_GROUPS)
+        throw ("syntax_error: SHOW -> a join takes at most " + to_string(JOIN_MAX_OR_GROUPS) + " OR groups.");
+    // Only the columns the join reads are decoded.
+    vector<int> used[2];
+    for (const auto &column : outputs)
+        used[column.side].push_back(column.column);
+    for (int side = 0; side < 2; side++) {
+        used[side].push_back(joinColumn[side]);
+        tables[side]->ensureColumns(used[side]);
+    }
+    vector<vector<vector<Condition>>> groups[2];
+    for (int side = 0; side < 2; side++) {
+        for (const auto &tokens : groupTokens[side]) {
+            auto parsed = tables[side]->parseAdvancedConditions(tokens);
+            groups[side].push_back({parsed.empty() ? vector<Condition>() : parsed[0]});
+        }
+    }
+
+    // A primary key join column is probed with findRow; otherwise the
+    // smaller filtered side is hashed.
+    bool primary[2] = {left.primaryKeyIndex == joinColumn[JOIN_LEFT],
+                       right.primaryKeyIndex == joinColumn[JOIN_RIGHT]};
+    JoinInput inputs[2];
+    int build, probe;
+    if (primary[JOIN_LEFT] || primary[JOIN_RIGHT]) {
+        if (primary[JOIN_LEFT] && primary[JOIN_RIGHT])
+            build = left.rowCount() >= right.rowCount() ? JOIN_LEFT : JOIN_RIGHT;
+        else
+            build = primary[JOIN_LEFT] ? JOIN_LEFT : JOIN_RIGHT;
+        probe = 1 - build;
+        inputs[probe] = tables[probe]->joinInput(groups[probe]);
+    } else {
+        inputs[JOIN_LEFT] = left.joinInput(groups[JOIN_LEFT]);
+        inputs[JOIN_RIGHT] = right.joinInput(groups[JOIN_RIGHT]);
+        build = inputs[JOIN_LEFT].rows.size() <= inputs[JOIN_RIGHT].rows.size() ? JOIN_LEFT : JOIN_RIGHT;
+        probe = 1 - build;
+    }
+    Table &buildTable = *tables[build], &probeTable = *tables[probe];
+    unique_ptr<JoinHashTable> hashTable;
+    if (!primary[build]) {
+        PhaseTimer joining(PHASE_JOIN);
+        vector<string_view> keys;
+        keys.reserve(inputs[build].rows.size());
+        for (const Row *row : inputs[build].rows)
+            keys.push_back(buildTable.cellAt(*row, joinColumn[build]));
+        hashTable.reset(new JoinHashTable(keys));
+    }
+
+    typedef vector<pair<const Row *, const Row *>> JoinedRows; // (left, right)
+    auto probeRange = [&](size_t begin, size_t end, JoinedRows &out) {
+        for (size_t i = begin; i < end; i++) {
+            const Row *row = inputs[probe].rows[i];
+            uint64_t mask = inputs[probe].masks[i];
+            const string &value = probeTable.cellAt(*row, joinColumn[probe]);
+            if (value == "null")
+                continue; // nulls never join
+            auto emit = [&](const Row *match) {
+                if (probe == JOIN_LEFT)
+                    out.emplace_back(row, match);
+                else
+                    out.emplace_back(match, row);
+            };
+            if (hashTable) {
+                hashTable->forEachMatch(value, [&](uint32_t entry) {
+                    if (mask & inputs[build].masks[entry])
+                        emit(inputs[build].rows[entry]);
+                });
+            } else {
+                // findRow matches integer keys by value ("+7" finds 7); the
+                // join compares the stored text, as the hash table does.
+                const Row *match = buildTable.findRow(value);
+                if (match && buildTable.cellAt(*match, joinColumn[build]) == value &&
+                    (mask & buildTable.joinMask(*match, groups[build])))
+                    emit(match);
+            }
+        }
+    };
+
+    // Output is paged as in show, sizing the columns a page at a time.
+    vector<string> labels;
+    for (const auto &output : outputs)
+        labels.push_back(output.label);
+    BasicResultPager<JoinedRows::value_type> pager(
+        labels, [&](const JoinedRows::value_type &joined, size_t o) -> const string & {
+            const Row *row = outputs[o].side == JOIN_LEFT ? joined.first : joined.second;
+            return tables[outputs[o].side]->cellAt(*row, outputs[o].column);
+        });
+    // Probe rows are matched a batch at a time and printed in probe order.
+    size_t total = inputs[probe].rows.size();
+    vector<JoinedRows> buffers;
+    for (size_t start = 0; start < total && !pager.stoppedByUser(); start += JOIN_PROBE_BATCH) {
+        size_t end = min(total, start + JOIN_PROBE_BATCH);
+        size_t workers = min<size_t>(thread::hardware_concurrency(), (end - start) / PARALLEL_JOIN_MIN);
+        workers = max<size_t>(workers, 1);
+        buffers.resize(workers);
+        for (auto &buffer : buffers)
+            buffer.clear();
+        {
+            PhaseTimer joining(PHASE_JOIN);
+            vector<thread> threads;
+            for (size_t w = 1; w < workers; w++) {
+                threads.emplace_back([&, w] {
+                    probeRange(start + (end - start) * w / workers, start + (end - start) * (w + 1) / workers,
+                               buffers[w]);
+                });
+            }
+            probeRange(start, start + (end - start) / workers, buffers[0]);
+            for (auto &t : threads)
+                t.join();
+        }
+        for (const auto &buffer : buffers) {
+            for (const auto &joined : buffer) {
+                if (!pager.add(joined))
+                    break;
+                queryProfile.rowsMatched++;
+            }
+        }
+        pager.flush(); // the buffers are reused by the next batch
+    }
+    pager.finish();
+}
+
 vector<vector<Condition>> Table::parseAdvancedConditions(const vector<string>& tokens) {
+    PhaseTimer compiling(PHASE_CONDITIONS);
     // so logically speaking for this cond1 AND cond2 OR cond3 AND cond4
     // this is how it gets stored in groups: 
     /*[
@@ -1340,7 +2705,7 @@ vector<vector<Condition>> Table::parseAdvancedConditions(const vector<string>& t
         return trimmed;
     };
 
-    int i = 0;
+    size_t i = 0;
     while (i < tokens.size()) {
         if (i + 2 < tokens.size()) {
             Condition cond;
@@ -1350,12 +2715,21 @@ vector<vector<Condition>> Table::parseAdvancedConditions(const vector<string>& t
 
             // --- Column name validation here ---
             bool columnExists = false;
-            for (const auto &header : headers) {
-                if (header == cond.column) {
-                    string dataType = columnMeta[cond.column].first;
-                    if( cond.value == "null" || !validateValue(cond.value,dataType)){
+            for (int c = 0; c < (int)headers.size(); c++) {
+                if (headers[c] == cond.column) {
+                    const string &dataType = schema[c].typeName;
+                    if( cond.value == "null" || !schema[c].validator(cond.value)){
                         throw ("mismatch_error: Value "+ cond.value +" is not valid for column " + cond.column + " of type " + dataType + ".");
                     }
+                    cond.colIndex = c;
+                    ensureColumns({c});
+                    if (schema[c].dictEncoded)
+                        cond.code = dictionaries[schema[c].slot].find(cond.value);
+                    if (cond.op == MATCHES) {
+                        if (!schema[c].has(COLUMN_FULLTEXT))
+                            throw logic_error("MATCHES -> column " + cond.column + " has no fulltext index, use make fulltext index on " + cond.column + ".");
+                        resolveFulltextMatch(cond);
+                    }
                     columnExists = true;
                     break;
                 }
@@ -1385,13 +2759,14 @@ vector<vector<Condition>> Table::parseAdvancedConditions(const vector<string>& t
 
 // Overload that updates only the specified column.
 void Table::updateValueByCondition(const string &colName, const string &oldValue, const string &newValue,const vector<vector<Condition>> &conditionGroups) {
+    loadForRewrite();
     int colIndex = -1;
-    for (int i = 0; i < headers.size(); i++) {
+    for (int i = 0; i < (int)headers.size(); i++) {
         if (headers[i] == colName) {
-            string dataType = columnMeta[colName].first;
-            if( oldValue == "null" || !validateValue(oldValue,dataType) ){
+            const string &dataType = schema[i].typeName;
+            if( oldValue == "null" || !schema[i].validator(oldValue) ){
                 throw ("mismatch_error: Value "+ oldValue +" is not valid for column " + colName + " of type " + dataType + ".");
-            } else if (newValue == "null" || !validateValue(newValue,dataType) ){
+            } else if (newValue == "null" || !schema[i].validator(newValue) ){
                 throw ("mismatch_error: Value "+ newValue +" is not valid for column " + colName + " of type " + dataType + ".");
             }
             colIndex = i;
@@ -1401,23 +2776,25 @@ void Table::updateValueByCondition(const string &colName, const string &oldValue
     if (colIndex == -1) {
         throw invalid_argument("Column: \"" + colName + "\" not found.");
     }
-    if (colIndex == primaryKeyIndex && dataMap.find(newValue) != dataMap.end()) { 
+    if (colIndex == primaryKeyIndex && findRow(newValue)) { 
         throw ("Constraint Error: Primary Key " + newValue + " already exists. Skipping Updation.");
     }
     int updateCount = 0;
-    for (auto &pair : dataMap) {
+    forEachCandidateRow(conditionGroups, [&](Row &row) {
         // Evaluate advanced conditions on the row.
-        if (evaluateAdvancedConditions(pair.second, conditionGroups)) {
-            int idx = colIndex - 1;
-            if (idx < pair.second.values.size() && pair.second.values[idx] == oldValue) {
-                pair.second.values[idx] = newValue;
+        if (colIndex != primaryKeyIndex && evaluateAdvancedConditions(row, conditionGroups)) {
+            queryProfile.rowsMatched++;
+            if (cellAt(row, colIndex) == oldValue) {
+                setCell(row, colIndex, newValue);
                 updateCount++;
             }
         }
-    }
+    });
     if (updateCount > 0){
         cout <<"res : " << updateCount << " row(s) updated successfully." << endl;
         unsavedChanges = true;
+        zoneMapsValid = false;
+        fulltextRows.clear();
     }   
     else
         throw invalid_argument("Logic ERR: No matching rows found with " + colName + " = " + oldValue + " under the given conditions." );
@@ -1426,25 +2803,27 @@ void Table::updateValueByCondition(const string &colName, const string &oldValue
 
 // Overload that updates across all columns (except primary key) where any cell equals oldValue.
 void Table::updateValueByCondition(const string &oldValue, const string &newValue,const vector<vector<Condition>> &conditionGroups) {
+    loadForRewrite();
     int updateCount = 0;
-    for (auto &pair : dataMap) {
-        if (evaluateAdvancedConditions(pair.second, conditionGroups)) {
+    forEachCandidateRow(conditionGroups, [&](Row &row) {
+        if (evaluateAdvancedConditions(row, conditionGroups)) {
+            queryProfile.rowsMatched++;
             // For each column (except primary key), update if the cell equals oldValue.
-            for (int i = 0; i < headers.size(); i++) {
-                if(i == primaryKeyIndex && dataMap.find(newValue) != dataMap.end()){
+            for (int i = 0; i < (int)headers.size(); i++) {
+                if (i == primaryKeyIndex)
                     continue;
-                }
-                int idx = i - 1;
-                if (idx < pair.second.values.size() && pair.second.values[idx] == oldValue) {
-                    pair.second.values[idx] = newValue;
+                if (cellAt(row, i) == oldValue) {
+                    setCell(row, i, newValue);
                     updateCount++;
                 }
             }
         }
-    }
+    });
     if (updateCount > 0){
         cout <<"Response: " << updateCount << " row(s) updated successfully." << endl;
         unsavedChanges = true;
+        zoneMapsValid = false;
+        fulltextRows.clear();
     }
     else
         cout << "No matching rows found with " << oldValue << " under the given conditions." << endl;
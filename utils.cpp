@@ -12,6 +12,12 @@ extern string currentDatabase; // Currently selected database name (empty if non
 extern string currentTable;    // Currently selected table name (empty if none)
 extern bool exitProgram;
 extern string aesKey;
+#include "profiler.cpp"
+#include "metrics.cpp"
+#include "validation.cpp"
+#include "durability.cpp"
+#include "storage.cpp"
+#include "catalog.cpp"
 //--------------------------------------------------------------------------------
 // Database & Table Creation / Erasure Functions
 //--------------------------------------------------------------------------------
@@ -21,45 +27,14 @@ string trimStr(const string &s);
 // Creates a new database directory if it does not exist.
 bool isValidDatabaseName(const string& name) {
     // Only allow alphabets (upper and lower case), numbers, and underscores.
-    regex validPattern("^[A-Za-z0-9_]+$");
-    return regex_match(name, validPattern);
-}
-void removeTableMetadataEntry(const string &tr,const string &metaFileName = "table_metadata.txt") {
-    // Construct the full path to metadata file.
-    string metaFilePath = (fs::path(fs_path) / currentDatabase / metaFileName).string();
-
-    // Read all lines from the metadata file.
-    vector<string> lines;
-    ifstream metaIn(metaFilePath);
-    if (!metaIn.is_open()) {
-        // File might not exist (or be created later), so nothing to remove.
-        return;
-    }
-    string line;
-    while (getline(metaIn, line)) {
-        // Use a stringstream to extract the first token (table name).
-        istringstream iss(line);
-        string token;
-        iss >> token;
-        // Only keep lines that do NOT refer to the table we are erasing.
-        if (token != tr) {
-            lines.push_back(line);
-        }
-    }
-    metaIn.close();
-
-    // Rewrite the metadata file without the removed table.
-    ofstream metaOut(metaFilePath);
-    if (!metaOut.is_open()) {
-        // If we cannot open the file for writing, just return.
-        return;
-    }
-    for (const auto &l : lines) {
-        metaOut << l << "\n";
+    if (name.empty())
+        return false;
+    for (unsigned char c : name) {
+        if (!isalnum(c) && c != '_')
+            return false;
     }
-    metaOut.close();
+    return true;
 }
-
 void init_database(string name) {
     if (!isValidDatabaseName(name)) {
         throw logic_error("Invalid database name! Only alphabets, numbers, and underscores are allowed.");
@@ -67,6 +42,7 @@ void init_database(string name) {
     fs::path db_path = fs::path(fs_path) / name;
     if (!fs::exists(db_path)) {
         if (fs::create_directory(db_path)) {
+            catalogSetTableCount(name, 0);
             // cout << "Database created: " << name << endl;
             // cout << "To access it, use: ENTER " << name << endl;
         } else {
@@ -107,6 +83,7 @@ std::string sha256WithSalt(const std::string& input, const std::string& salt) {
 // Encrypts plainText using AES-256-CBC.
 // The 'key' must be 32 bytes (256 bits). 'ivOut' is set to the random IV.
 std::string aesEncrypt(const std::string &plainText, std::string &ivOut) {
+    bytesEncryptedMetric.add(plainText.size());
     EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
     if (!ctx) throw std::runtime_error("Failed to create encryption context");
 
@@ -143,6 +120,8 @@ std::string aesEncrypt(const std::string &plainText, std::string &ivOut) {
 
 // Decrypts cipherText (which was encrypted using AES-256-CBC) using the given key and iv.
 std::string aesDecrypt(const std::string &cipherText, const std::string &iv) {
+    queryProfile.bytesDecrypted += cipherText.size();
+    bytesDecryptedMetric.add(cipherText.size());
     EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
     if (!ctx) throw std::runtime_error("Failed to create decryption context");
 
@@ -182,16 +161,7 @@ string trimStr(const string &s) {
     return s.substr(start, end - start + 1); // ✅ The result includes the character at start_index,❌ But does NOT use an end_index.
 }
 bool isValidDataType(const string &dataType) {
-    // Use dummy values for type checking
-    if (dataType == "INT") return true;
-    if (dataType == "BIGINT") return true;
-    if (dataType == "DOUBLE") return true;
-    if (dataType == "BIGDOUBLE") return true;
-    if (dataType == "CHAR") return true;
-    if (dataType == "VARCHAR" || dataType == "STRING") return true;
-    if (dataType == "DATE") return true;
-    if (dataType == "BOOL") return true;
-    return false; // Unknown type
+    return parseDataType(dataType) != TYPE_UNKNOWN;
 }
 
 bool isValidConstraint(const string &constraint) {
@@ -205,6 +175,7 @@ void eraseDatabase(const string &dbName) {
     fs::path db_path = fs::path(fs_path) / dbName; 
     if (fs::exists(db_path) && fs::is_directory(db_path)) {
         fs::remove_all(db_path);
+        catalogRemoveDatabase(dbName);
         // cout << "Database erased: " << fs::absolute(db_path).string() << endl; /////////- --- - - - - - ----- - - - --     ----------------    - - - ->>>> comment out this line
     } else {
         throw logic_error("Database not found: " + dbName);
@@ -283,6 +254,25 @@ void make_table(list<string> &queryList, const string tableName) {
     
     headersToken = trimStr(headersToken);
 
+    // Optional block compression codec: make <table>(...) compress <codec>
+    CompressionCodec codec = CODEC_LZ4;
+    if (!queryList.empty() && queryList.front() == COMPRESS) {
+        queryList.pop_front();
+        if (queryList.empty())
+            throw ("syntax_error: COMPRESS -> missing codec name.");
+        codec = parseCodec(queryList.front());
+        queryList.pop_front();
+    }
+    // Optional write path: make <table>(...) [compress <codec>] engine lsm
+    TableEngine engine = ENGINE_REWRITE;
+    if (!queryList.empty() && queryList.front() == STORAGE_ENGINE) {
+        queryList.pop_front();
+        if (queryList.empty())
+            throw ("syntax_error: ENGINE -> missing engine name.");
+        engine = parseEngine(queryList.front());
+        queryList.pop_front();
+    }
+
     string filename = tableName + ".bin";
     ifstream file(filename);
     if (file.good()) {
@@ -377,25 +367,13 @@ void make_table(list<string> &queryList, const string tableName) {
         }
     }
     
-    // Create the CSV string (only header row for now).
-    string csvData = finalHeader + "\n";
-
-    // --- AES Encryption Step ---
-    // Instead of using the simple XOR encryption, now use aesEncrypt.
-    // aesEncrypt accepts the plaintext (csvData), the AES key, and returns the ciphertext,
-    // while also setting the IV (initialization vector) passed by reference.
-    std::string iv;  // IV will be generated inside aesEncrypt.
-    std::string cipherText = aesEncrypt(csvData, iv);
-    
-    // --- Write Encrypted Data to the Binary File ---
-    // We will write the IV first (fixed size: AES_BLOCK_SIZE) and then the ciphertext.
-    ofstream newTable(filename, ios::binary);
-    if (!newTable.is_open()) {
+    // --- Write the encrypted table file (header only, no data blocks yet) ---
+    TableFileWriter newTable(codec, finalHeader, engine);
+    try {
+        newTable.writeTo(filename);
+    } catch (const runtime_error &) {
         throw ("program_error: Failed to create table!");
     }
-    newTable.write(iv.c_str(), AES_BLOCK_SIZE);
-    newTable.write(cipherText.c_str(), cipherText.size());
-    newTable.close();
     
     cout << "\033[32mres: Table Created Successfully.\033[0m" << endl;
 }
@@ -432,10 +410,12 @@ void processHelp() {
 
     cout << HDR << "Table Commands:" << RESET << "\n";
     printLine("make <table>(...)",    "Create a new table with columns.");
-    cout << "       " << ARG << "Syntax: make users(id INT PRIMARY, name VARCHAR)" << RESET << "\n";
+    cout << "       " << ARG << "Syntax: make users(id INT PRIMARY, name VARCHAR) [compress none|lz4] [engine lsm]" << RESET << "\n";
+    printLine("make fulltext index on <col>", "Index the words of a text column for MATCHES.");
     printLine("choose <table>",       "Open a table in current database.");
     printLine("erase <table>",        "Delete a table (inside a DB).");
     printLine("clean",                "Remove all rows in the current table.");
+    printLine("compress <codec>",     "Set the table's block compression (applied on commit).");
     cout << "       " << ARG << "* Must choose a table first." << RESET << "\n\n";
 
     cout << HDR << "Data Operations:" << RESET << "\n";
@@ -454,104 +434,49 @@ void processHelp() {
     cout << "     " << ARG << "* show head - first 5 rows\n";
     cout << "     " << ARG << "* show limit N - first N rows\n";
     cout << "     " << ARG << "* show limit ~N - last N rows\n";
-    cout << "     " << ARG << "* show <cols> [where/like]\n\n";
+    cout << "     " << ARG << "* show <cols> [where/like]\n";
+    cout << "     " << ARG << "* show <cols> like '<pattern>' - % any text, _ one char, case-insensitive\n";
+    cout << "     " << ARG << "* show <cols> where <col> matches 'word1 word2' - rows containing every word\n";
+    cout << "     " << ARG << "* show <cols> ... order by <col> [asc|desc] [limit N]\n";
+    cout << "     " << ARG << "* show count(*), sum(col), avg(col), min(col), max(col) [where ...] [group by col]\n";
+    cout << "     " << ARG << "* show <cols> from <a> join <b> on a.col = b.col [where ...]\n\n";
 
     cout << HDR << "Transactions & Misc:" << RESET << "\n";
     printLine("rollback",             "Undo unsaved changes.");
     printLine("commit",               "Save changes to disk.");
     printLine("close",                "Close table and return to database.");
     printLine("help",                 "Show this help screen.");
+    printLine("\\timing [on|off]",     "Print the time taken by each command.");
+    printLine("profile <command>",    "Run a command and break down where its time went.");
+    printLine("\\slowlog [<ms>|off]",  "Log commands slower than <ms> to slow.log.");
+    printLine("\\pager [<rows>|off]",  "Pause show output after every <rows> rows.");
+    printLine("\\sync [full|normal|off]", "Choose how much commit flushes to disk.");
+    printLine("stats",                "Show counters and latencies since startup.");
+    cout << "     " << ARG << "* stats prometheus - print them in the Prometheus text format\n";
+    cout << "     " << ARG << "* stats export [file] - write that to a file (default metrics.prom)" << RESET << "\n";
     cout << "\n" << TIT << "==================================================================" << RESET << "\n\n";
 }
-// Lists all databases (directories) in the root DBMS folder.
+// Lists the databases with their table counts, from the root catalog.
 void listDatabases() {
     fs::path rootPath = fs::path(fs_path);  // Root DBMS folder
     if (!fs::exists(rootPath)) {
         throw ("program_error: Installation went wrong unistall and install again.");
         
     }
-    bool databaseFound = false;
-    for (const auto &entry : fs::directory_iterator(rootPath)) {
-        if (entry.is_directory()) {
-            string dbName = entry.path().filename().string();
-            if (!dbName.empty() && dbName[0] == '.')// ✅ Skips hidden directories (starting with '.')
-                continue;
-            int tableCount = 0;
-            databaseFound = true;
-            for (const auto &f : fs::directory_iterator(entry.path())) { // fs::directory_iterator loops through each file in the db-name
-                string fileName = f.path().filename().string();
-                // ✅ Skips hidden files
-                if (!fileName.empty() && fileName[0] == '.')
-                    continue;
-                // Count CSV files (tables), ignoring the metadata file.
-                if (f.is_regular_file() && f.path().extension() == ".bin" &&
-                    f.path().stem().string() != "table_metadata")
-                    tableCount++;
-            }
-            cout << dbName << " - " << tableCount << " tb" << endl;
-        }
-    }
-    if(!databaseFound) cout<<"\033[31mEmpty\033[0m"<<endl;
+    map<string, uint32_t> databases = rootCatalog();
+    for (const auto &db : databases)
+        cout << db.first << " - " << db.second << " tb" << endl;
+    if(databases.empty()) cout<<"\033[31mEmpty\033[0m"<<endl;
 }
 
-// Lists all tables (CSV files) in the current database directory.
+// Lists the tables of the current database with their row counts, from its catalog.
 void listTables() {
-    fs::path dbPath = fs::path(fs_path) / currentDatabase;  // Current directory is the selected database.
-    fs::path metaPath = dbPath / "table_metadata.txt";
-
-    // Check if the table_metadata.txt file exists.
-    if (fs::exists(metaPath) && fs::is_regular_file(metaPath)) {
-        ifstream metaFile(metaPath);
-        if (!metaFile.is_open()) {
-            // throw ("program_error: unable to open table_metadata.txt");
-        }
-        string line;
-        bool tableFound = false;
-        // Read and log each non-empty line from table_metadata.txt.
-        while (getline(metaFile, line)) {
-            if (!line.empty()) {
-                cout << line << endl;
-                tableFound = true;
-            }
-        }
-        metaFile.close();
-        // If metadata exists but is empty, log "no tables".
-        if (!tableFound) {
-            cout << "\033[31mEmpty Database\033[0m" << endl;
-        }
-    }else {
+    map<string, CatalogTable> tables = databaseCatalog(fs::path(fs_path) / currentDatabase);
+    for (const auto &table : tables)
+        cout << table.first << " - " << table.second.rows << " rows" << endl;
+    if (tables.empty()) {
         cout << "\033[31mEmpty Database\033[0m" << endl;
     }
-    // else {  // If table_metadata.txt does not exist, fallback to listing CSV files.
-    //     bool tableFound = false;
-    //     for (const auto &entry : fs::directory_iterator(dbPath)) {
-    //         if (entry.is_regular_file() && entry.path().extension() == ".csv") {
-    //             string tableName = entry.path().stem().string();
-    //             // Skip any CSV whose stem is "table_metadata".
-    //             if (tableName == "table_metadata")
-    //                 continue;
-    //             int rowCount = 0;
-    //             ifstream file(entry.path());
-    //             string line;
-    //             bool header = true;
-    //             while(getline(file, line)) {
-    //                 if (header) {
-    //                     header = false;
-    //                     continue;
-    //                 }
-    //                 if (!line.empty()){
-    //                     tableFound = true;
-    //                     rowCount++;
-    //                 }
-    //             }
-    //             file.close();
-    //             cout << tableName << " - " << rowCount << " rows" << endl;
-    //         }
-    //         if (!tableFound) {
-    //             cout << "\033[31mEmpty Database\033[0m" << endl;
-    //         }
-    //     }
-    // }
 }
 
 
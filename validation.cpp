@@ -0,0 +1,178 @@
+#include <charconv>
+#include <cerrno>
+#include <cstring>
+
+// Column value validation.
+// A column's data type is resolved to a DataType once and its checker is kept
+// by the table, so validating a cell is a single indirect call with no string
+// comparisons, regex construction or allocation.
+
+enum DataType : uint8_t {
+    TYPE_INT,
+    TYPE_BIGINT,
+    TYPE_DOUBLE,
+    TYPE_BIGDOUBLE,
+    TYPE_CHAR,
+    TYPE_VARCHAR,
+    TYPE_STRING,
+    TYPE_DATE,
+    TYPE_BOOL,
+    TYPE_UNKNOWN
+};
+
+DataType parseDataType(const string &dataType) {
+    if (dataType == "INT") return TYPE_INT;
+    if (dataType == "BIGINT") return TYPE_BIGINT;
+    if (dataType == "DOUBLE") return TYPE_DOUBLE;
+    if (dataType == "BIGDOUBLE") return TYPE_BIGDOUBLE;
+    if (dataType == "CHAR") return TYPE_CHAR;
+    if (dataType == "VARCHAR") return TYPE_VARCHAR;
+    if (dataType == "STRING") return TYPE_STRING;
+    if (dataType == "DATE") return TYPE_DATE;
+    if (dataType == "BOOL") return TYPE_BOOL;
+    return TYPE_UNKNOWN;
+}
+
+bool isNumericType(DataType type) {
+    return type == TYPE_INT || type == TYPE_BIGINT || type == TYPE_DOUBLE || type == TYPE_BIGDOUBLE;
+}
+
+bool isStringType(DataType type) {
+    return type == TYPE_CHAR || type == TYPE_VARCHAR || type == TYPE_STRING;
+}
+
+// The whole of [first, last) must be consumed and the value must be in range.
+// An explicit '+' sign is accepted, as stoi/stod did.
+template <typename T>
+static bool parsesFully(const char *first, const char *last) {
+    if (first != last && *first == '+' && last - first > 1 && first[1] != '-' && first[1] != '+')
+        first++;
+    T parsed;
+    auto result = from_chars(first, last, parsed);
+    return result.ec == errc() && result.ptr == last;
+}
+
+static bool isValidInt(const string &value) {
+    return parsesFully<int>(value.data(), value.data() + value.size());
+}
+
+static bool isValidBigInt(const string &value) {
+    return parsesFully<long long>(value.data(), value.data() + value.size());
+}
+
+// Some standard libraries (older libc++ in particular) lack floating point
+// from_chars; fall back to strtod/strtold there.
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+static bool isValidDouble(const string &value) {
+    return parsesFully<double>(value.data(), value.data() + value.size());
+}
+
+static bool isValidBigDouble(const string &value) {
+    return parsesFully<long double>(value.data(), value.data() + value.size());
+}
+#else
+static bool isValidDouble(const string &value) {
+    if (value.empty() || isspace(static_cast<unsigned char>(value[0])))
+        return false;
+    char *end = nullptr;
+    errno = 0;
+    strtod(value.c_str(), &end);
+    return errno != ERANGE && end == value.c_str() + value.size();
+}
+
+static bool isValidBigDouble(const string &value) {
+    if (value.empty() || isspace(static_cast<unsigned char>(value[0])))
+        return false;
+    char *end = nullptr;
+    errno = 0;
+    strtold(value.c_str(), &end);
+    return errno != ERANGE && end == value.c_str() + value.size();
+}
+#endif
+
+static bool isValidChar(const string &value) {
+    return value.size() == 1;
+}
+
+static bool isValidText(const string &value) {
+    return !value.empty();
+}
+
+static bool isLeapYear(int year) {
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+// Strict YYYY-MM-DD with a real calendar day (leap years included).
+static bool isValidDate(const string &value) {
+    if (value.size() != 10 || value[4] != '-' || value[7] != '-')
+        return false;
+    int parts[3] = {0, 0, 0};
+    const int starts[3] = {0, 5, 8};
+    const int lengths[3] = {4, 2, 2};
+    for (int p = 0; p < 3; p++) {
+        for (int k = starts[p]; k < starts[p] + lengths[p]; k++) {
+            if (value[k] < '0' || value[k] > '9')
+                return false;
+            parts[p] = parts[p] * 10 + (value[k] - '0');
+        }
+    }
+    int year = parts[0], month = parts[1], day = parts[2];
+    if (month < 1 || month > 12)
+        return false;
+    static const int daysInMonth[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    int lastDay = daysInMonth[month - 1] + ((month == 2 && isLeapYear(year)) ? 1 : 0);
+    return day >= 1 && day <= lastDay;
+}
+
+// Case-insensitive true/false, or 1/0.
+static bool isValidBool(const string &value) {
+    auto equalsIgnoreCase = [&value](const char *word) {
+        size_t n = strlen(word);
+        if (value.size() != n)
+            return false;
+        for (size_t i = 0; i < n; i++) {
+            if (tolower(static_cast<unsigned char>(value[i])) != word[i])
+                return false;
+        }
+        return true;
+    };
+    return value == "1" || value == "0" || equalsIgnoreCase("true") || equalsIgnoreCase("false");
+}
+
+static bool isUnknownType(const string &) {
+    return false;
+}
+
+// Checks one non-null cell.
+typedef bool (*ValueValidator)(const string &value);
+
+ValueValidator validatorFor(DataType type) {
+    switch (type) {
+        case TYPE_INT: return isValidInt;
+        case TYPE_BIGINT: return isValidBigInt;
+        case TYPE_DOUBLE: return isValidDouble;
+        case TYPE_BIGDOUBLE: return isValidBigDouble;
+        case TYPE_CHAR: return isValidChar;
+        case TYPE_VARCHAR:
+        case TYPE_STRING: return isValidText;
+        case TYPE_DATE: return isValidDate;
+        case TYPE_BOOL: return isValidBool;
+        default: return isUnknownType;
+    }
+}
+
+// "null" is accepted for every type; constraints decide whether it is allowed.
+inline bool validateCell(ValueValidator validator, const string &value) {
+    return value == "null" || validator(value);
+}
+
+// Validates a column worth of values at once (e.g. for a bulk load).
+// Returns the index of the first invalid value, or values.size() if all pass.
+size_t findInvalidValue(DataType type, const vector<string> &values) {
+    ValueValidator validator = validatorFor(type);
+    for (size_t i = 0; i < values.size(); i++) {
+        if (!validateCell(validator, values[i]))
+            return i;
+    }
+    return values.size();
+}